@@ -0,0 +1,215 @@
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+ImageData::~ImageData() {
+    if (pixels)
+        stbi_image_free(pixels);
+}
+
+AssetLoader& AssetLoader::Get() {
+    static AssetLoader loader;
+    return loader;
+}
+
+// one thread stays free for the GL thread
+AssetLoader::AssetLoader() : m_start(std::chrono::steady_clock::now()) {
+    unsigned int count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for (unsigned int i = 0; i < count; ++i)
+        m_workers.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobReady.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void AssetLoader::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobReady.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+// queues the job once per key, the entry is marked done (and the GL thread woken up) when it ran
+std::shared_ptr<AssetLoader::Entry> AssetLoader::request(const std::string& key, const std::string& name, std::function<void(Entry&)> job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<Entry>& entry = m_entries[key];
+    if (entry)
+        return entry;
+
+    entry = std::make_shared<Entry>();
+    entry->timing.name = name;
+    m_finished.push_back(entry);
+
+    std::shared_ptr<Entry> target = entry;
+    m_jobs.push_back([this, target, job]() {
+        auto start = std::chrono::steady_clock::now();
+        job(*target);
+        double ms = Milliseconds(std::chrono::steady_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            target->timing.decodeMs = ms;
+            target->done = true;
+        }
+        m_jobDone.notify_all();
+    });
+    m_jobReady.notify_one();
+    return entry;
+}
+
+void AssetLoader::wait(const std::shared_ptr<Entry>& entry) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobDone.wait(lock, [&entry] { return entry->done; });
+    entry->timing.waitMs += Milliseconds(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string imageKey(const std::string& path, int desiredChannels, bool flip, bool allowBaked) {
+    return "image:" + path + "|" + std::to_string(desiredChannels) + (flip ? "|flip" : "") + (allowBaked ? "|ktx" : "");
+}
+
+void AssetLoader::PrefetchImage(const std::string& path, int desiredChannels, bool flip, bool allowBaked) {
+    request(imageKey(path, desiredChannels, flip, allowBaked), path, [path, desiredChannels, flip, allowBaked](Entry& entry) {
+        decodeImage(entry, path, desiredChannels, flip, allowBaked);
+    });
+}
+
+void AssetLoader::PrefetchModel(const std::string& path) {
+    request("model:" + path, path, [this, path](Entry& entry) {
+        importModel(entry, path);
+    });
+}
+
+std::shared_ptr<const ImageData> AssetLoader::TakeImage(const std::string& path, int desiredChannels, bool flip, bool allowBaked) {
+    PrefetchImage(path, desiredChannels, flip, allowBaked);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry = m_entries[imageKey(path, desiredChannels, flip, allowBaked)];
+    }
+    wait(entry);
+    return entry->image;
+}
+
+std::shared_ptr<ModelPayload> AssetLoader::TakeModel(const std::string& path) {
+    PrefetchModel(path);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry = m_entries["model:" + path];
+    }
+    wait(entry);
+    return entry->model;
+}
+
+void AssetLoader::AddUploadTime(const std::string& name, double ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::shared_ptr<Entry>& entry : m_finished) {
+        if (entry->timing.name == name) {
+            entry->timing.uploadMs += ms;
+            return;
+        }
+    }
+}
+
+// a baked .ktx with the same row order is only mapped, otherwise the image is decoded;
+// stbi keeps the flip flag per thread here, so the workers don't change it for each other
+void AssetLoader::decodeImage(Entry& entry, const std::string& path, int desiredChannels, bool flip, bool allowBaked) {
+    std::shared_ptr<ImageData> image = std::make_shared<ImageData>();
+    if (allowBaked && TextureFile::Map(image->baked, TextureFile::BakedPath(path), TextureFile::HashSource(path), flip, image->texture)) {
+        image->width = static_cast<int>(image->texture.levels[0].width);
+        image->height = static_cast<int>(image->texture.levels[0].height);
+        image->channels = image->components = 4;
+        entry.image = image;
+        return;
+    }
+    image->baked.Close();
+    image->texture = TextureFileView();
+
+    stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+    image->pixels = stbi_load(path.c_str(), &image->width, &image->height, &image->channels, desiredChannels);
+    image->components = desiredChannels != 0 ? desiredChannels : image->channels;
+    entry.image = image;
+}
+
+// the baked file when it belongs to the source, otherwise an Assimp import that is baked for the next start;
+// the textures of the model are queued as soon as their names are known
+void AssetLoader::importModel(Entry& entry, const std::string& path) {
+    std::shared_ptr<ModelPayload> payload = std::make_shared<ModelPayload>();
+    std::string bakedPath = ModelFile::BakedPath(path);
+    uint64_t sourceHash = ModelFile::HashSource(path);
+
+    if (ModelFile::Map(payload->baked, bakedPath, sourceHash, payload->view)) {
+        payload->valid = true;
+        payload->fromBakedFile = true;
+    }
+    else {
+        payload->baked.Close();
+        payload->valid = ModelFile::Import(path, payload->imported);
+        if (payload->valid) {
+            try {
+                ModelFile::Save(bakedPath, payload->imported, sourceHash);
+            }
+            catch (const std::exception& e) {
+                std::cout << "ERROR::MODEL::" << e.what() << std::endl;
+            }
+            payload->view = ModelFile::View(payload->imported);
+        }
+    }
+
+    if (payload->valid) {
+        size_t lastSlash = path.find_last_of("/\\");
+        std::string directory = (lastSlash == std::string::npos) ? "" : path.substr(0, lastSlash + 1);
+        for (const std::string& texture : payload->view.materialTextures) {
+            if (!texture.empty())
+                TextureCache::Prefetch(directory + texture, TextureSettings::Colormap());
+        }
+    }
+    entry.model = payload;
+}
+
+// prints where the startup time went and frees the payloads, assets that are asked for later are loaded on demand
+void AssetLoader::Finish() {
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.swap(m_finished);
+        m_entries.clear();
+    }
+    double wallMs = Milliseconds(std::chrono::steady_clock::now() - m_start).count();
+
+    double decode = 0.0, waitTotal = 0.0, upload = 0.0;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Assets (" << m_workers.size() << " loader threads): decode / wait / upload ms" << std::endl;
+    for (const std::shared_ptr<Entry>& entry : entries) {
+        const AssetTiming& timing = entry->timing;
+        std::cout << "  " << std::setw(7) << timing.decodeMs << std::setw(7) << timing.waitMs << std::setw(7) << timing.uploadMs
+            << "  " << timing.name << std::endl;
+        decode += timing.decodeMs;
+        waitTotal += timing.waitMs;
+        upload += timing.uploadMs;
+    }
+    std::cout << "  " << std::setw(7) << decode << std::setw(7) << waitTotal << std::setw(7) << upload
+        << "  total, startup took " << wallMs << " ms" << std::endl;
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
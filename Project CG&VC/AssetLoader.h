@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+#include "ModelFile.h"
+#include "TextureFile.h"
+
+// A decoded image, the pixels are freed with the payload; for a texture that was baked into a .ktx
+// the mip levels point into the mapped file instead and pixels stays empty
+struct ImageData {
+	int width = 0;
+	int height = 0;
+	int channels = 0;		// channels in the file
+	int components = 0;		// channels in pixels (the requested count, or the file's)
+	unsigned char* pixels = nullptr;
+	MappedFile baked;
+	TextureFileView texture;
+
+	bool IsBaked() const { return !texture.levels.empty(); }
+
+	ImageData() = default;
+	~ImageData();
+	ImageData(const ImageData&) = delete;
+	ImageData& operator=(const ImageData&) = delete;
+};
+
+// An imported model: a mapped baked file, or the result of an Assimp import
+struct ModelPayload {
+	MappedFile baked;
+	ModelMeshData imported;
+	ModelMeshView view;		// points into baked or imported
+	bool valid = false;
+	bool fromBakedFile = false;
+};
+
+// Where the time of one asset went
+struct AssetTiming {
+	std::string name;
+	double decodeMs = 0.0;	// on a worker: file I/O, decode, import
+	double waitMs = 0.0;	// the GL thread waited for the worker
+	double uploadMs = 0.0;	// on the GL thread
+};
+
+/*
+* Loads the assets of the scene on a thread pool while the GL thread builds the scene
+* containts:
+*		- Prefetch*: queues file I/O, image decoding and model imports on the workers
+*		- Take*: the GL thread picks up a finished payload (waiting for it when needed) and uploads it
+*		- an asset that was never prefetched is loaded on a worker as soon as it is asked for
+*		- per asset timings, printed by Finish, which also frees the payloads that are left
+*/
+class AssetLoader {
+public:
+	static AssetLoader& Get();
+	~AssetLoader();
+
+	// flip and desiredChannels (0 = as in the file) are part of the key, like in stbi_load; allowBaked
+	// takes the .ktx next to the image when there is one (for textures, not for pixels that are read)
+	void PrefetchImage(const std::string& path, int desiredChannels, bool flip, bool allowBaked = false);
+	void PrefetchModel(const std::string& path);
+
+	std::shared_ptr<const ImageData> TakeImage(const std::string& path, int desiredChannels, bool flip, bool allowBaked = false);
+	std::shared_ptr<ModelPayload> TakeModel(const std::string& path);
+
+	void AddUploadTime(const std::string& name, double ms);
+
+	void Finish();
+
+private:
+	struct Entry {
+		AssetTiming timing;
+		bool done = false;
+		std::shared_ptr<ImageData> image;
+		std::shared_ptr<ModelPayload> model;
+	};
+
+	AssetLoader();
+
+	std::shared_ptr<Entry> request(const std::string& key, const std::string& name, std::function<void(Entry&)> job);
+	void wait(const std::shared_ptr<Entry>& entry);
+	void workerLoop();
+
+	static void decodeImage(Entry& entry, const std::string& path, int desiredChannels, bool flip, bool allowBaked);
+	void importModel(Entry& entry, const std::string& path);
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	std::condition_variable m_jobDone;
+	std::deque<std::function<void()>> m_jobs;
+	std::vector<std::thread> m_workers;
+	bool m_stopping = false;
+
+	std::map<std::string, std::shared_ptr<Entry>> m_entries;
+	std::vector<std::shared_ptr<Entry>> m_finished;		// in the order they were asked for, for the report
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// Adds the time until the end of the scope to the upload time of an asset
+class AssetUploadTimer {
+public:
+	explicit AssetUploadTimer(const std::string& name) : m_name(name), m_start(std::chrono::steady_clock::now()) {}
+	~AssetUploadTimer() {
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+		AssetLoader::Get().AddUploadTime(m_name, elapsed.count());
+	}
+
+private:
+	std::string m_name;
+	std::chrono::steady_clock::time_point m_start;
+};
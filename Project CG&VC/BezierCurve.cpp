@@ -2,6 +2,14 @@
 
 #include <stdexcept>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BEZIER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BEZIER_SSE
+#endif
+
 /* 
 * Constructor for the BezierCurve class
 * initializes the controlPoints
@@ -102,3 +110,141 @@ glm::vec3 BezierCurve::GetTangent(float t) const {
 
     return glm::vec3(0.0f);
 }
+
+/*
+* GenerateAdaptiveParameters returns the parameters t (from 0 to 1) of an adaptive tessellation
+* every one of the minSteps uniform intervals is split in half until
+*		- the curve deviates less than tolerance from the chord, and
+*		- the tangent turns less than maxAngle (radians) over the interval
+* an interval is never smaller than 1 / maxSteps
+*/
+std::vector<float> BezierCurve::GenerateAdaptiveParameters(float tolerance, float maxAngle, int minSteps, int maxSteps) const {
+    if (minSteps <= 0 || maxSteps < minSteps) {
+        throw std::runtime_error("Adaptive tessellation requires 0 < minSteps <= maxSteps.");
+    }
+
+    std::vector<float> parameters;
+    parameters.push_back(0.0f);
+
+    float cosMaxAngle = cos(maxAngle);
+    float minInterval = 1.0f / maxSteps;
+    for (int i = 0; i < minSteps; ++i) {
+        subdivide(static_cast<float>(i) / minSteps, static_cast<float>(i + 1) / minSteps, tolerance, cosMaxAngle, minInterval, parameters);
+    }
+    parameters.back() = 1.0f;
+
+    return parameters;
+}
+
+// adds the end parameters of the flat pieces of [t0, t1]
+void BezierCurve::subdivide(float t0, float t1, float tolerance, float cosMaxAngle, float minInterval, std::vector<float>& parameters) const {
+    if (t1 - t0 > minInterval) {
+        glm::vec3 p0 = GetPoint(t0);
+        glm::vec3 p1 = GetPoint(t1);
+        glm::vec3 chord = p1 - p0;
+        float chordLength2 = glm::dot(chord, chord);
+
+        // distance of the quarter points to the chord
+        float deviation = 0.0f;
+        for (float f : { 0.25f, 0.5f, 0.75f }) {
+            glm::vec3 d = GetPoint(glm::mix(t0, t1, f)) - p0;
+            if (chordLength2 > 0.0f)
+                d -= chord * (glm::dot(d, chord) / chordLength2);
+            deviation = glm::max(deviation, glm::length(d));
+        }
+
+        // how much the direction changes
+        glm::vec3 tangent0 = GetTangent(t0);
+        glm::vec3 tangent1 = GetTangent(t1);
+        float lengths = glm::length(tangent0) * glm::length(tangent1);
+        float cosAngle = lengths > 0.0f ? glm::dot(tangent0, tangent1) / lengths : 1.0f;
+
+        if (deviation > tolerance || cosAngle < cosMaxAngle) {
+            float tm = 0.5f * (t0 + t1);
+            subdivide(t0, tm, tolerance, cosMaxAngle, minInterval, parameters);
+            subdivide(tm, t1, tolerance, cosMaxAngle, minInterval, parameters);
+            return;
+        }
+    }
+
+    parameters.push_back(t1);
+}
+
+/*
+* EvaluateBatch evaluates the curve and its derivative for many parameters at once
+* uses the polynomial form B(t) = ((a*t + b)*t + c)*t + d and B'(t) = (3a*t + 2b)*t + c
+* per component (x, y, z) the parameters are processed 8 (AVX) or 4 (SSE) at a time, the rest is done scalar
+*/
+void BezierCurve::EvaluateBatch(const float* t, size_t count, float* x, float* y, float* z, float* tx, float* ty, float* tz) const {
+    if (m_controlPoints.size() != 4) {
+        throw std::runtime_error("EvaluateBatch only supports cubic Bezier curves (4 control points).");
+    }
+
+    const glm::vec3& p0 = m_controlPoints[0];
+    const glm::vec3& p1 = m_controlPoints[1];
+    const glm::vec3& p2 = m_controlPoints[2];
+    const glm::vec3& p3 = m_controlPoints[3];
+
+    glm::vec3 a = -p0 + 3.0f * (p1 - p2) + p3;
+    glm::vec3 b = 3.0f * (p0 - 2.0f * p1 + p2);
+    glm::vec3 c = 3.0f * (p1 - p0);
+    glm::vec3 d = p0;
+
+    float* positions[3] = { x, y, z };
+    float* tangents[3] = { tx, ty, tz };
+    bool withTangents = tx && ty && tz;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float* out = positions[axis];
+        float* outTangent = tangents[axis];
+        size_t i = 0;
+
+#if defined(BEZIER_AVX)
+        __m256 va = _mm256_set1_ps(a[axis]);
+        __m256 vb = _mm256_set1_ps(b[axis]);
+        __m256 vc = _mm256_set1_ps(c[axis]);
+        __m256 vd = _mm256_set1_ps(d[axis]);
+        __m256 va3 = _mm256_set1_ps(3.0f * a[axis]);
+        __m256 vb2 = _mm256_set1_ps(2.0f * b[axis]);
+        for (; i + 8 <= count; i += 8) {
+            __m256 vt = _mm256_loadu_ps(t + i);
+            __m256 p = _mm256_add_ps(_mm256_mul_ps(va, vt), vb);
+            p = _mm256_add_ps(_mm256_mul_ps(p, vt), vc);
+            p = _mm256_add_ps(_mm256_mul_ps(p, vt), vd);
+            _mm256_storeu_ps(out + i, p);
+            if (withTangents) {
+                __m256 tan = _mm256_add_ps(_mm256_mul_ps(va3, vt), vb2);
+                tan = _mm256_add_ps(_mm256_mul_ps(tan, vt), vc);
+                _mm256_storeu_ps(outTangent + i, tan);
+            }
+        }
+#elif defined(BEZIER_SSE)
+        __m128 va = _mm_set1_ps(a[axis]);
+        __m128 vb = _mm_set1_ps(b[axis]);
+        __m128 vc = _mm_set1_ps(c[axis]);
+        __m128 vd = _mm_set1_ps(d[axis]);
+        __m128 va3 = _mm_set1_ps(3.0f * a[axis]);
+        __m128 vb2 = _mm_set1_ps(2.0f * b[axis]);
+        for (; i + 4 <= count; i += 4) {
+            __m128 vt = _mm_loadu_ps(t + i);
+            __m128 p = _mm_add_ps(_mm_mul_ps(va, vt), vb);
+            p = _mm_add_ps(_mm_mul_ps(p, vt), vc);
+            p = _mm_add_ps(_mm_mul_ps(p, vt), vd);
+            _mm_storeu_ps(out + i, p);
+            if (withTangents) {
+                __m128 tan = _mm_add_ps(_mm_mul_ps(va3, vt), vb2);
+                tan = _mm_add_ps(_mm_mul_ps(tan, vt), vc);
+                _mm_storeu_ps(outTangent + i, tan);
+            }
+        }
+#endif
+
+        // scalar fallback and remainder
+        for (; i < count; ++i) {
+            float ti = t[i];
+            out[i] = ((a[axis] * ti + b[axis]) * ti + c[axis]) * ti + d[axis];
+            if (withTangents)
+                outTangent[i] = (3.0f * a[axis] * ti + 2.0f * b[axis]) * ti + c[axis];
+        }
+    }
+}
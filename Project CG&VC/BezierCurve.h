@@ -26,10 +26,20 @@ public:
 
 	glm::vec3 GetTangent(float t) const;
 
+	// evaluates count parameters at once (SSE/AVX when available), results are written in SoA layout
+	// the tangent outputs may be nullptr when only the positions are needed
+	void EvaluateBatch(const float* t, size_t count, float* x, float* y, float* z,
+		float* tx = nullptr, float* ty = nullptr, float* tz = nullptr) const;
+
+	// parameters for an adaptive tessellation: flat parts get few steps, tight bends get many
+	std::vector<float> GenerateAdaptiveParameters(float tolerance, float maxAngle, int minSteps, int maxSteps) const;
+
 private:
 	std::vector<glm::vec3> m_controlPoints;
 	std::vector<glm::vec3> m_curvePoints;
 
+	void subdivide(float t0, float t1, float tolerance, float cosMaxAngle, float minInterval, std::vector<float>& parameters) const;
+
 
 };
 
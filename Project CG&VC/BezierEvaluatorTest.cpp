@@ -0,0 +1,90 @@
+// Test for BezierCurve::EvaluateBatch: the SIMD kernels and the scalar remainder have to match
+// the forward difference points (positions) and GetTangent (tangents) of the same curve
+//
+// usage: BezierEvaluatorTest   (returns 0 when every curve matches, 1 otherwise)
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BezierCurve.h"
+
+// both errors are relative to the size of the curve
+static const float POSITION_TOLERANCE = 1e-4f;
+static const float TANGENT_TOLERANCE = 1e-4f;
+
+static float curveSize(const std::vector<glm::vec3>& controlPoints) {
+	float size = 1.0f;
+	for (const glm::vec3& point : controlPoints)
+		size = glm::max(size, glm::length(point - controlPoints[0]));
+	return size;
+}
+
+// evaluates the curve at the forward difference parameters i / steps and compares every point
+static bool checkCurve(const char* name, const std::vector<glm::vec3>& controlPoints, int steps) {
+	BezierCurve curve(controlPoints);
+	std::vector<glm::vec3> reference = curve.GeneratePoints(steps);
+
+	size_t count = reference.size();
+	std::vector<float> parameters(count);
+	for (size_t i = 0; i < count; ++i)
+		parameters[i] = static_cast<float>(i) / steps;
+
+	std::vector<float> x(count), y(count), z(count), tx(count), ty(count), tz(count);
+	curve.EvaluateBatch(parameters.data(), count, x.data(), y.data(), z.data(), tx.data(), ty.data(), tz.data());
+
+	// the same positions have to come out when the tangents are skipped
+	std::vector<float> px(count), py(count), pz(count);
+	curve.EvaluateBatch(parameters.data(), count, px.data(), py.data(), pz.data());
+
+	float size = curveSize(controlPoints);
+	float positionError = 0.0f;
+	float tangentError = 0.0f;
+	float skippedError = 0.0f;
+	for (size_t i = 0; i < count; ++i) {
+		glm::vec3 position = glm::vec3(x[i], y[i], z[i]);
+		positionError = glm::max(positionError, glm::length(position - reference[i]) / size);
+		skippedError = glm::max(skippedError, glm::length(glm::vec3(px[i], py[i], pz[i]) - position) / size);
+
+		glm::vec3 tangent = curve.GetTangent(parameters[i]);
+		tangentError = glm::max(tangentError, glm::length(glm::vec3(tx[i], ty[i], tz[i]) - tangent) / size);
+	}
+
+	bool passed = positionError <= POSITION_TOLERANCE && tangentError <= TANGENT_TOLERANCE && skippedError == 0.0f;
+	std::cout << (passed ? "ok      " : "FAILED  ") << name << " (" << count << " samples, position error " << positionError
+		<< ", tangent error " << tangentError << ")" << std::endl;
+	return passed;
+}
+
+int main() {
+	std::vector<std::vector<glm::vec3>> curves = {
+		{ glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(3.0f, 0.0f, 0.0f) },
+		{ glm::vec3(0.0f), glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(10.0f, 20.0f, 5.0f), glm::vec3(10.0f, 0.0f, 5.0f) },
+		{ glm::vec3(-50.0f, 3.0f, 12.0f), glm::vec3(40.0f, -8.0f, 90.0f), glm::vec3(-70.0f, 25.0f, -30.0f), glm::vec3(60.0f, 1.0f, 0.0f) },
+		{ glm::vec3(100.0f, 10.0f, 100.0f), glm::vec3(100.0f, 10.0f, 100.0f), glm::vec3(101.0f, 10.0f, 100.0f), glm::vec3(101.0f, 10.0f, 100.0f) },
+	};
+
+	// random curves in the size of the track
+	srand(1234);
+	for (int i = 0; i < 16; ++i) {
+		std::vector<glm::vec3> controlPoints;
+		for (int j = 0; j < 4; ++j)
+			controlPoints.push_back(glm::vec3(rand() % 400 - 200, rand() % 60, rand() % 400 - 200));
+		curves.push_back(controlPoints);
+	}
+
+	// step counts that leave 0 to 7 parameters for the scalar remainder after the SIMD loop
+	int steps[] = { 1, 2, 3, 4, 7, 8, 9, 15, 16, 23, 100 };
+
+	bool passed = true;
+	for (size_t c = 0; c < curves.size(); ++c) {
+		for (int s : steps) {
+			std::string name = "curve " + std::to_string(c) + ", " + std::to_string(s) + " steps";
+			passed = checkCurve(name.c_str(), curves[c], s) && passed;
+		}
+	}
+
+	std::cout << (passed ? "All curves match" : "ERROR::BEZIEREVALUATORTEST::Batch evaluation differs from the reference") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -1,10 +1,10 @@
 #version 330 core
 
-out vec4 FragColor;
+in vec3 vertexColor;
 
-uniform vec3 objectColor;
+out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(objectColor, 1.0);
+    FragColor = vec4(vertexColor, 1.0);
 }
\ No newline at end of file
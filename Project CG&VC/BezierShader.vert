@@ -1,7 +1,8 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
 
-out vec4 vertexColor;
+out vec3 vertexColor;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -9,5 +10,5 @@ uniform mat4 projection;
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0); 
-    vertexColor = vec4(0.5, 0.5, 0.5, 1.0); //kleur grijs
+    vertexColor = aColor; // rail, crossbar or pillar color
 }
\ No newline at end of file
@@ -1 +1,61 @@
 #include "BezierTrack.h"
+#include "TrackFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+BezierTrack::BezierTrack(const std::string& path) : m_segments(TrackFile::Load(path)) {
+    MakeSegmentsSmooth();
+}
+
+void BezierTrack::Save(const std::string& path) const {
+    if (path.size() >= 7 && path.compare(path.size() - 7, 7, ".trackb") == 0)
+        TrackFile::SaveBinary(path, m_segments);
+    else
+        TrackFile::SaveText(path, m_segments);
+}
+
+/*
+* MoveControlPoint moves control point index (0..3) of a segment
+*		- an end point takes its two handles along, so the shape around the joint stays the same
+*		- the first handle of a segment is mirrored onto the last handle of the previous segment
+* only the joints next to the edited point are smoothed again
+*/
+std::vector<int> BezierTrack::MoveControlPoint(int segment, int index, const glm::vec3& position) {
+    int count = static_cast<int>(m_segments.size());
+    if (segment < 0 || segment >= count || index < 0 || index > 3)
+        throw std::out_of_range("MoveControlPoint: invalid segment or control point index.");
+
+    // the start point of a segment is the end point of the previous one
+    if (index == 0) {
+        segment = (segment - 1 + count) % count;
+        index = 3;
+    }
+
+    int prev = (segment - 1 + count) % count;
+    int next = (segment + 1) % count;
+    auto& seg = m_segments[segment];
+
+    std::vector<int> dirty;
+    if (index == 3) {
+        glm::vec3 delta = position - seg[3];
+        seg[3] = position;
+        seg[2] += delta;
+        SmoothJoint(next);
+        dirty = { segment, next };
+    }
+    else if (index == 2) {
+        seg[2] = position;
+        SmoothJoint(next);
+        dirty = { segment, next };
+    }
+    else {
+        m_segments[prev][2] = seg[0] - (position - seg[0]);
+        SmoothJoint(segment);
+        dirty = { prev, segment };
+    }
+
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    return dirty;
+}
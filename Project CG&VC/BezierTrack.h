@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -9,6 +10,10 @@ public:
 		MakeSegmentsSmooth();
     }
 
+	// loads a text (.track) or binary (.trackb) track file, see TrackFile
+	explicit BezierTrack(const std::string& path);
+	void Save(const std::string& path) const;
+
 	void MakeSegmentsSmooth() {
 		for (size_t i = 1; i < m_segments.size(); ++i) {
 			// Vorig segment
@@ -29,6 +34,18 @@ public:
 		first[1] = first[0] + (last[3] - last[2]);
 	}
 
+	// restores C0/C1 continuity between a segment and the one before it
+	void SmoothJoint(int segment) {
+		int count = static_cast<int>(m_segments.size());
+		auto& prev = m_segments[(segment - 1 + count) % count];
+		auto& curr = m_segments[segment];
+		curr[0] = prev[3];
+		curr[1] = curr[0] + (prev[3] - prev[2]);
+	}
+
+	// moves one control point and keeps the track smooth, returns the segments that changed
+	std::vector<int> MoveControlPoint(int segment, int index, const glm::vec3& position);
+
     std::vector<std::vector<glm::vec3>>& GetSegments() { return m_segments; }
     const std::vector<std::vector<glm::vec3>>& GetSegments() const { return m_segments; }
 
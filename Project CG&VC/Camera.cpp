@@ -76,6 +76,14 @@ void Camera::ProcessMouseScroll(float yoffset)
         Zoom = 45.0f;
 }
 
+void Camera::SetPose(glm::vec3 position, float yaw, float pitch, float zoom) {
+    Position = position;
+    Yaw = yaw;
+    Pitch = pitch;
+    Zoom = zoom;
+    updateCameraVectors();
+}
+
 void Camera::ChangeOption() {
     cameraOption = (cameraOption + 1) % 2;
     std::cout << cameraOption << std::endl;
@@ -96,8 +104,9 @@ void Camera::updateCameraVectors()
     Up = glm::normalize(glm::cross(Right, Front));
 }
 
-void Camera::UpdateCartCamera(glm::vec3 cartPos, glm::vec3 cartDir) {
-    glm::vec3 cameraOffset = -cartDir * 3.0f + glm::vec3(0.0f, 4.0f, 0.0f);
+void Camera::UpdateCartCamera(glm::vec3 cartPos, glm::vec3 cartDir, glm::vec3 cartUp) {
+    // the up vector comes from the track frame, so the camera stays above the cart in loops
+    glm::vec3 cameraOffset = -cartDir * 3.0f + cartUp * 4.0f;
     Position = cartPos + cameraOffset;
     Front = glm::normalize(cartDir);
     Yaw = glm::degrees(atan2(cartDir.z, cartDir.x));
@@ -61,8 +61,11 @@ public:
     // Changes the camera option
     void ChangeOption();
 
+    // puts the camera at a recorded pose (replays)
+    void SetPose(glm::vec3 position, float yaw, float pitch, float zoom);
+
     // Updates the camera for the cart camera
-    void UpdateCartCamera(glm::vec3 cartPos, glm::vec3 cartDir);
+    void UpdateCartCamera(glm::vec3 cartPos, glm::vec3 cartDir, glm::vec3 cartUp);
 
 private:
     // calculates the front vector from the Camera's (updated) Euler Angles
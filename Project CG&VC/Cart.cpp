@@ -1,100 +1,147 @@
 #include "Cart.h"
 
 // Constructor
-Cart::Cart(RollerCoaster* coaster, float speed)
+Cart::Cart(RollerCoaster* coaster, float speed, int carCount)
 	: m_rollerCoaster(coaster), m_model(".\\models\\cart\\coaster-train-front.fbx"), m_wagonModel(".\\models\\cart\\coaster-train.fbx"),
-    m_shader(".\\CartShader.vert", ".\\CartShader.frag"), m_speed(speed), m_t(0.0f), m_currentCurveIndex(0) {
+    m_shader(".\\CartShader.vert", ".\\CartShader.frag"), m_instancedShader(".\\CartInstancedShader.vert", ".\\CartShader.frag"),
+    m_carCount(glm::max(carCount, 1)), m_speed(speed), m_t(0.0f), m_currentCurveIndex(0) {
 
 	InitializeBuffers();
+
+	// the lights come from the shared uniform buffer
+	m_shader.bindUniformBlock("Lights", LightUniformBuffer::BINDING_POINT);
+	m_instancedShader.bindUniformBlock("Lights", LightUniformBuffer::BINDING_POINT);
+
+	// one matrix per wagon, rewritten every frame
+	m_wagonMatrices.resize(m_carCount - 1);
+	glGenBuffers(1, &m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_wagonMatrices.size() * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_physics.mass = m_mass;
+	m_physics.PlaceChainOnFirstClimb(m_rollerCoaster->getSampler());
+	m_simulation.current.velocity = m_physics.chainSpeed;
+	m_simulation.previous = m_simulation.current;
+
 	updatePositionAndDirection();
+	updateWagons();
 }
 
-// this method updates on which bezier curve segment the cart is on
 void Cart::Update(float deltaTime) {
-    BezierCurve& currentCurve = (m_rollerCoaster->getCurves())[m_currentCurveIndex];
+    simulate(glm::min(deltaTime, m_maxFrameTime));
+}
 
-    float tangentLength = glm::length(currentCurve.GetTangent(m_t));
-    if (tangentLength > 0.0001f) {
-        m_t += (m_speed * deltaTime) / tangentLength;
-    }
-    else {
-        m_t += m_speed * deltaTime; // fallback
-    }
+void Cart::FastForward(float seconds) {
+    simulate(seconds);
+}
 
-    if (m_t > 1.0f) {
-        m_t = 0.0f;
-        m_currentCurveIndex++;
-        if (m_currentCurveIndex >= m_rollerCoaster->getCurves().size()) {
-            m_currentCurveIndex = 0;
-        }
-    }
+void Cart::SetPhysicsEnabled(bool enabled) {
+    m_simulation.physicsEnabled = enabled ? 1 : 0;
+    if (enabled)
+        m_physics.PlaceChainOnFirstClimb(m_rollerCoaster->getSampler());
+}
 
-    updatePositionAndDirection();
+void Cart::OnTrackEdited() {
+    const TrackSampler& sampler = m_rollerCoaster->getSampler();
+    m_physics.PlaceChainOnFirstClimb(sampler);
+    m_simulation.previous.distance = sampler.WrapDistance(m_simulation.previous.distance);
+    m_simulation.current.distance = sampler.WrapDistance(m_simulation.current.distance);
+    simulate(0.0f);
 }
 
+void Cart::ApplySnapshot(const CartSnapshot& snapshot) {
+    m_simulation = snapshot;
 
-// update the position and direction of the cart
-void Cart::updatePositionAndDirection() {
-	// current curve
-	BezierCurve& currentCurve = (m_rollerCoaster->getCurves())[m_currentCurveIndex];
+    // no steps, only the interpolation and the car matrices
+    simulate(0.0f);
+}
 
-	// position on the curve
-	m_position = currentCurve.GetPoint(m_t);
+// this method advances the cart by distance and looks up on which bezier curve segment it is
+// the simulation always runs in steps of CartPhysics::TIMESTEP, so the ride is the same at every frame rate
+void Cart::simulate(float seconds) {
+    const TrackSampler& sampler = m_rollerCoaster->getSampler();
 
-	// recalculate direction
-	glm::vec3 nextPos = currentCurve.GetPoint(m_t + 0.01f);
-	m_direction = glm::normalize(nextPos - m_position);
+    m_physics.Advance(sampler, m_simulation, seconds, m_speed);
 
-    // calculate the "up" vector
-    glm::vec3 up(0.0f, 1.0f, 0.0f); // Assuming Y-axis is up
-    glm::vec3 right = glm::normalize(glm::cross(up, m_direction));
-    up = glm::normalize(glm::cross(m_direction, right));
+    // render between the last two steps, the remainder decides how far
+    float alpha = m_simulation.accumulator / CartPhysics::TIMESTEP;
+    m_renderDistance = CartPhysics::Interpolate(sampler, m_simulation.previous.distance, m_simulation.current.distance, alpha);
 
-    // Apply an offset to position the cart above the curve
-    float heightOffset = 0.60f; // Adjust this value to control the height above the curve
-    m_position += up * heightOffset;
+    TrackLocation location = sampler.LocateDistance(m_renderDistance);
+    m_currentCurveIndex = location.curve;
+    m_t = location.t;
 
+    updatePositionAndDirection();
+    updateWagons();
 }
 
-// render the cart
-void Cart::Render(const glm::mat4& projection, const glm::mat4& view, std::vector<PointLight> pointLights, glm::vec3 cameraPos) {
-    // Calculate orientation matrix
-    glm::mat4 rotation = glm::mat4(1.0f);
-    glm::vec3 up(0.0f, 1.0f, 0.0f);
-    glm::vec3 right = glm::normalize(glm::cross(up, m_direction));
-    up = glm::cross(m_direction, right);
+// the wagons follow the front car, every one oriented by the track frame at its own distance
+void Cart::updateWagons() {
+    const TrackSampler& sampler = m_rollerCoaster->getSampler();
+    float heightOffset = 0.60f;
+    for (size_t i = 0; i < m_wagonMatrices.size(); ++i) {
+        TrackSample sample = sampler.SampleAtDistance(m_renderDistance - (i + 1) * m_carSpacing);
+        m_wagonMatrices[i] = CarMatrix(sample.position + sample.up * heightOffset, sample.tangent, sample.right, sample.up);
+    }
+}
 
+// model matrix of a car, the models look along -z
+glm::mat4 Cart::CarMatrix(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& right, const glm::vec3& up) {
+    glm::mat4 rotation = glm::mat4(1.0f);
     rotation[0] = glm::vec4(right, 0.0f);
     rotation[1] = glm::vec4(up, 0.0f);
-    rotation[2] = glm::vec4(-m_direction, 0.0f);
+    rotation[2] = glm::vec4(-direction, 0.0f);
 
-	// compute the model matrix
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), m_position)
+    return glm::translate(glm::mat4(1.0f), position)
         * rotation
         * glm::scale(glm::mat4(1.0f), glm::vec3(0.05f, 0.05f, 0.05f));
+}
+
+
+// update the position and direction of the cart
+void Cart::updatePositionAndDirection() {
+	// read the position and frame from the baked track tables
+	TrackSample sample = m_rollerCoaster->getSampler().SampleAt(m_currentCurveIndex, m_t);
+
+	m_direction = sample.tangent;
+	m_right = sample.right;
+	m_up = sample.up;
+
+    // Apply an offset to position the cart above the curve
+    float heightOffset = 0.60f; // Adjust this value to control the height above the curve
+    m_position = sample.position + m_up * heightOffset;
+
+}
+
+// render the cart
+void Cart::Render(const glm::mat4& projection, const glm::mat4& view, glm::vec3 cameraPos) {
+	// compute the model matrix
+    glm::mat4 model = CarMatrix(m_position, m_direction, m_right, m_up);
 
 	// set the shader uniforms
     m_shader.use();
     m_shader.setMat4("projection", projection);
-
-    m_shader.setInt("numLights", pointLights.size());
-    for (size_t i = 0; i < pointLights.size(); ++i) {
-        std::string index = std::to_string(i);
-        m_shader.setVec3("lights[" + index + "].position", pointLights[i].position);
-        m_shader.setVec3("lights[" + index + "].color", pointLights[i].color);
-        m_shader.setFloat("lights[" + index + "].constant", pointLights[i].constant);
-        m_shader.setFloat("lights[" + index + "].linear", pointLights[i].linear);
-        m_shader.setFloat("lights[" + index + "].quadratic", pointLights[i].quadratic);
-    }
-
     m_shader.setVec3("viewPos", cameraPos);
-
     m_shader.setMat4("view", view);
     m_shader.setMat4("model", model);
 
     m_model.Draw(m_shader);
 
+    if (m_wagonMatrices.empty())
+        return;
+
+    // all wagons in one instanced draw
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_wagonMatrices.size() * sizeof(glm::mat4), m_wagonMatrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_instancedShader.use();
+    m_instancedShader.setMat4("projection", projection);
+    m_instancedShader.setMat4("view", view);
+    m_instancedShader.setVec3("viewPos", cameraPos);
 
+    m_wagonModel.DrawInstanced(m_instancedShader, m_instanceVBO, static_cast<int>(m_wagonMatrices.size()));
 }
 
 glm::vec3 Cart::GetPosition() const
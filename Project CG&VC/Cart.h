@@ -3,43 +3,82 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Shader.h"
+#include "CartPhysics.h"
 #include "RollerCoaster.h"
 #include "Model.h"
-#include "Light.h"
+#include "LightUniformBuffer.h"
 
+// The train: the front car (m_model) followed by carCount - 1 wagons (m_wagonModel) at a fixed
+// arc length spacing. All wagons are drawn with one instanced draw.
 class Cart {
 public:
-	Cart(RollerCoaster* rollercoaster, float speed);
+	Cart(RollerCoaster* rollercoaster, float speed, int carCount = 1);
 
+	// advances the simulation in fixed steps, the rendered position is interpolated between the last two steps
 	void Update(float deltaTime);
-	void Render(const glm::mat4& projection, const glm::mat4& view, std::vector<PointLight> lights, glm::vec3 cameraPos);
+	// runs the simulation without the frame time clamp, e.g. to skip ahead without rendering
+	void FastForward(float seconds);
+
+	// physics (gravity, friction, drag, lift hill) or the old constant speed ride
+	void SetPhysicsEnabled(bool enabled);
+	bool IsPhysicsEnabled() const { return m_simulation.physicsEnabled != 0; }
+	float GetVelocity() const { return m_simulation.current.velocity; }
+
+	// the track was edited: the lift hill moves to the new first climb and the distances are wrapped to the new length
+	void OnTrackEdited();
+
+	// the state of the fixed timestep loop, a replay applies a recorded snapshot instead of calling Update
+	CartSnapshot GetSnapshot() const { return m_simulation; }
+	void ApplySnapshot(const CartSnapshot& snapshot);
+	void Render(const glm::mat4& projection, const glm::mat4& view, glm::vec3 cameraPos);
 
 	glm::vec3 GetPosition() const;
 	glm::vec3 GetDirection() const;
+	glm::vec3 GetUp() const { return m_up; }
+	int GetCarCount() const { return m_carCount; }
 
 	Shader getShader() { return m_shader; }
 
+	// shared with TrainSystem
+	static glm::mat4 CarMatrix(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& right, const glm::vec3& up);
+
 
 private:
 	RollerCoaster* m_rollerCoaster;
 	Shader m_shader;
 	Model m_model;
 	Model m_wagonModel;
+	Shader m_instancedShader;
+
+	// train
+	int m_carCount;
+	float m_carSpacing = 7.0f;		// arc length between the centers of two cars (the cars are 6.5 long)
+	float m_renderDistance = 0.0f;	// interpolated distance of the front car
+	std::vector<glm::mat4> m_wagonMatrices;
+	unsigned int m_instanceVBO = 0;
 
-	float m_velocity = 0.0f;
-	float m_speed;
+	float m_speed;				// speed of the constant speed ride
 	float m_t;
 	int m_currentCurveIndex;
 
 	float m_mass = 100.0f;
 
+	// fixed timestep simulation
+	CartPhysics m_physics;
+	CartSnapshot m_simulation;		// the states before and after the last step and the accumulator
+	float m_maxFrameTime = 0.25f;	// a long frame (e.g. loading) doesn't make the simulation catch up forever
+
 	glm::vec3 m_position;
 	glm::vec3 m_direction;
+	glm::vec3 m_right;
+	glm::vec3 m_up;
 
 	unsigned int VAO, VBO, EBO;
 	unsigned int m_indexCount;
 
+	void simulate(float seconds);
 	void updatePositionAndDirection();
+	void updateWagons();
 	void InitializeBuffers();
 };
 
@@ -0,0 +1,25 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aModel;	// per instance, takes locations 3 to 6
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+#include "Packing.GLSL"
+
+void main() {
+    TexCoords = aTexCoords * uvScale + uvOffset;
+
+    FragPos = vec3(aModel * vec4(aPos * positionScale + positionOffset, 1.0f));
+    // the instance matrices only rotate and scale uniformly, the fragment shader normalizes
+    Normal = mat3(aModel) * decodeNormal(aNormal);
+
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,72 @@
+#include "CartPhysics.h"
+
+#include <algorithm>
+#include <cmath>
+
+float CartPhysics::Acceleration(const TrackSampler& sampler, float distance, float velocity) const {
+    TrackSample sample = sampler.SampleAtDistance(distance);
+
+    // the part of gravity along the track
+    float acceleration = -gravity * sample.tangent.y;
+
+    // friction and drag always work against the motion
+    if (velocity != 0.0f) {
+        float direction = velocity > 0.0f ? 1.0f : -1.0f;
+        acceleration -= direction * (rollingFriction * gravity + dragArea * velocity * velocity / mass);
+    }
+    return acceleration;
+}
+
+CartState CartPhysics::Step(const TrackSampler& sampler, const CartState& state, float dt) const {
+    CartState next;
+    next.velocity = state.velocity + Acceleration(sampler, state.distance, state.velocity) * dt;
+
+    // the chain doesn't let the cart go slower than the chain itself
+    if (IsOnChain(state.distance) && next.velocity < chainSpeed)
+        next.velocity = chainSpeed;
+
+    next.distance = sampler.WrapDistance(state.distance + next.velocity * dt);
+    return next;
+}
+
+int CartPhysics::Advance(const TrackSampler& sampler, CartSnapshot& simulation, float seconds, float constantSpeed) const {
+    // count the steps up front, taking TIMESTEP off a large accumulator one step at a time drifts
+    simulation.accumulator += seconds;
+    int steps = static_cast<int>(simulation.accumulator / TIMESTEP);
+    simulation.accumulator = std::max(simulation.accumulator - steps * TIMESTEP, 0.0f);
+
+    for (int i = 0; i < steps; ++i) {
+        simulation.previous = simulation.current;
+        if (simulation.physicsEnabled) {
+            simulation.current = Step(sampler, simulation.current, TIMESTEP);
+        }
+        else {
+            // the wrap keeps the remainder when the cart passes the end of the track
+            simulation.current.velocity = constantSpeed;
+            simulation.current.distance = sampler.WrapDistance(simulation.current.distance + constantSpeed * TIMESTEP);
+        }
+    }
+    return steps;
+}
+
+float CartPhysics::Interpolate(const TrackSampler& sampler, float previous, float current, float alpha) {
+    float total = sampler.GetTotalLength();
+    float delta = current - previous;
+    // the shortest way around the closed track
+    if (delta > total * 0.5f)
+        delta -= total;
+    else if (delta < -total * 0.5f)
+        delta += total;
+    return sampler.WrapDistance(previous + delta * alpha);
+}
+
+void CartPhysics::PlaceChainOnFirstClimb(const TrackSampler& sampler) {
+    const std::vector<TrackSample>& samples = sampler.GetSamples();
+    size_t crest = 0;
+    while (crest + 1 < samples.size() && samples[crest + 1].position.y >= samples[crest].position.y)
+        ++crest;
+
+    // a bit past the crest so the cart doesn't stop on top
+    chainStart = 0.0f;
+    chainEnd = samples.empty() ? 0.0f : samples[crest].distance + 1.0f;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "TrackSampler.h"
+
+// Where a cart is on the track, the distance is kept within [0, track length)
+struct CartState {
+	float distance = 0.0f;
+	float velocity = 0.0f;
+};
+
+// Everything the fixed timestep loop of a cart needs to continue, used to record and replay rides
+struct CartSnapshot {
+	CartState previous;
+	CartState current;
+	float accumulator = 0.0f;
+	uint32_t physicsEnabled = 1;
+};
+
+/*
+* One dimensional physics of a cart along the track (the track keeps it on the rails)
+* containts:
+*		- gravity along the tangent, rolling friction and quadratic air drag
+*		- a lift hill chain that pulls the cart up at a fixed speed
+*		- fixed timestep steps, the caller accumulates frame time and interpolates between steps
+*/
+class CartPhysics {
+public:
+	static constexpr float TIMESTEP = 1.0f / 120.0f;
+
+	float gravity = 9.81f;
+	float rollingFriction = 0.015f;		// coefficient, the friction force is mu * m * g
+	float dragArea = 0.15f;				// 0.5 * air density * drag coefficient * frontal area
+	float mass = 100.0f;
+
+	// lift hill, between two arc lengths
+	float chainStart = 0.0f;
+	float chainEnd = 0.0f;
+	float chainSpeed = 8.0f;
+
+	// semi-implicit Euler, the acceleration is evaluated at the current position
+	CartState Step(const TrackSampler& sampler, const CartState& state, float dt) const;
+	// adds frame time to the accumulator and takes all whole steps it holds, returns the number of steps.
+	// Without physics the cart rides at constantSpeed, also in fixed steps.
+	int Advance(const TrackSampler& sampler, CartSnapshot& simulation, float seconds, float constantSpeed) const;
+	float Acceleration(const TrackSampler& sampler, float distance, float velocity) const;
+
+	// puts the chain from the start of the track up to the first crest
+	void PlaceChainOnFirstClimb(const TrackSampler& sampler);
+
+	bool IsOnChain(float distance) const { return distance >= chainStart && distance < chainEnd; }
+
+	// interpolated distance between two steps, also when the cart passed the end of the track in between
+	static float Interpolate(const TrackSampler& sampler, float previous, float current, float alpha);
+};
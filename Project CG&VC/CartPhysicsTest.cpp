@@ -0,0 +1,140 @@
+// Headless test for CartPhysics: a ride on the default track has to come out the same at every frame rate
+//
+// usage: CartPhysicsTest [track file]   (default: .\tracks\default.track, returns 0 when every run matches)
+// Every run feeds 300 s of frame time into CartPhysics::Advance, the same loop Cart::Update uses.
+// The fixed steps make the states after step n independent of the frame rate, so every run has to
+// end exactly on the reference ride that calls Step directly. TrainSimulation (the stress test trains)
+// has to stay close to the same reference, in the SSE path and in the scalar one.
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "BezierTrack.h"
+#include "CartPhysics.h"
+#include "TrackSampler.h"
+#include "TrainSimulation.h"
+
+static const float RIDE_SECONDS = 300.0f;
+
+// the trains interpolate the slope in a table every 0.25 units instead of sampling the track, so they
+// drift away from the reference a little; the limits hold over the whole ride
+static const float TRAIN_VELOCITY_TOLERANCE = 0.01f;	// units per second
+static const float TRAIN_DISTANCE_TOLERANCE = 0.05f;	// units along the track
+
+struct RideResult {
+	int steps = 0;
+	CartState state;
+	float minVelocity = 1e30f;
+	float maxVelocity = 0.0f;
+};
+
+// frame time in slices of 1 / fps, fps 0 runs everything in one call like Cart::FastForward
+static RideResult ride(const CartPhysics& physics, const TrackSampler& sampler, const CartSnapshot& start, float fps) {
+	RideResult result;
+	CartSnapshot simulation = start;
+	int frames = fps > 0.0f ? static_cast<int>(std::lround(RIDE_SECONDS * fps)) : 1;
+	float deltaTime = fps > 0.0f ? 1.0f / fps : RIDE_SECONDS;
+
+	for (int frame = 0; frame < frames; ++frame) {
+		result.steps += physics.Advance(sampler, simulation, deltaTime, 0.0f);
+		result.minVelocity = std::fmin(result.minVelocity, simulation.current.velocity);
+		result.maxVelocity = std::fmax(result.maxVelocity, simulation.current.velocity);
+	}
+	result.state = simulation.current;
+	return result;
+}
+
+// the first of trainCount trains starts like the reference ride: 1 train runs in the scalar remainder, 4 in the SSE loop
+static bool checkTrains(const TrackSampler& sampler, const std::vector<CartState>& reference, int trainCount) {
+	TrainSimulation trains;
+	trains.Rebuild(sampler);
+	trains.SetTrainCount(trainCount);
+
+	float total = sampler.GetTotalLength();
+	float velocityError = 0.0f;
+	float distanceError = 0.0f;
+	for (size_t i = 1; i < reference.size(); ++i) {
+		trains.SimulateRange(0, trainCount, 1);
+		// the shortest way around the closed track
+		float distance = std::fabs(trains.GetDistance(0) - reference[i].distance);
+		velocityError = std::fmax(velocityError, std::fabs(trains.GetVelocity(0) - reference[i].velocity));
+		distanceError = std::fmax(distanceError, std::fmin(distance, total - distance));
+	}
+
+	bool passed = velocityError <= TRAIN_VELOCITY_TOLERANCE && distanceError <= TRAIN_DISTANCE_TOLERANCE;
+	std::cout << (passed ? "ok      " : "FAILED  ") << "TrainSimulation, " << trainCount << " train(s) (speed off by at most " << velocityError
+		<< ", distance by " << distanceError << ")" << std::endl;
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	std::string path = argc > 1 ? argv[1] : ".\\tracks\\default.track";
+
+	std::vector<BezierCurve> curves;
+	try {
+		BezierTrack track(path);
+		for (const auto& segment : track.GetSegments())
+			curves.push_back(BezierCurve(segment));
+	}
+	catch (const std::exception& e) {
+		std::cout << "ERROR::CARTPHYSICSTEST::" << e.what() << std::endl;
+		return 1;
+	}
+
+	TrackSampler sampler;
+	sampler.Build(curves);
+
+	CartPhysics physics;
+	physics.PlaceChainOnFirstClimb(sampler);
+
+	// the cart starts like the ride cart: at the start of the track at chain speed
+	CartSnapshot start;
+	start.current.velocity = physics.chainSpeed;
+	start.previous = start.current;
+
+	// the most steps any run can take, the reference keeps every state up to there
+	int maxSteps = static_cast<int>(RIDE_SECONDS / CartPhysics::TIMESTEP) + 2;
+	std::vector<CartState> reference(maxSteps + 1);
+	reference[0] = start.current;
+	float travelled = 0.0f;
+	for (int i = 0; i < maxSteps; ++i) {
+		reference[i + 1] = physics.Step(sampler, reference[i], CartPhysics::TIMESTEP);
+		travelled += reference[i + 1].velocity * CartPhysics::TIMESTEP;
+	}
+
+	bool passed = true;
+	float laps = travelled / sampler.GetTotalLength();
+	if (laps < 1.0f) {
+		std::cout << "FAILED  reference ride doesn't finish a lap (" << laps << " laps)" << std::endl;
+		passed = false;
+	}
+
+	float frameRates[] = { 7.0f, 30.0f, 60.0f, 144.0f, 240.0f, 0.0f };
+	for (float fps : frameRates) {
+		RideResult result = ride(physics, sampler, start, fps);
+
+		// float accumulation of the frame time may gain or lose one step over the whole ride
+		int expected = static_cast<int>(RIDE_SECONDS / CartPhysics::TIMESTEP);
+		bool stepsOk = result.steps >= expected - 1 && result.steps <= expected + 1;
+		bool stateOk = stepsOk && result.state.distance == reference[result.steps].distance &&
+			result.state.velocity == reference[result.steps].velocity;
+		// the cart must never stop or roll back
+		bool velocityOk = result.minVelocity > 0.0f;
+
+		bool ok = stepsOk && stateOk && velocityOk;
+		passed = passed && ok;
+		std::cout << (ok ? "ok      " : "FAILED  ") << (fps > 0.0f ? std::to_string(static_cast<int>(fps)) + " FPS" : std::string("fast-forward"))
+			<< " (" << result.steps << " steps, distance " << result.state.distance << ", speed " << result.minVelocity
+			<< " to " << result.maxVelocity << ")" << std::endl;
+	}
+
+	passed = checkTrains(sampler, reference, 1) && passed;
+	passed = checkTrains(sampler, reference, 4) && passed;
+
+	std::cout << (passed ? "All rides match" : "ERROR::CARTPHYSICSTEST::Ride differs between frame rates or from the trains") << std::endl;
+	return passed ? 0 : 1;
+}
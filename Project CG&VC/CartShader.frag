@@ -1,16 +1,19 @@
 #version 330 core
-#define MAX_LIGHTS 6
+#define MAX_LIGHTS 8
 
 struct PointLight {
     vec3 position;
-    vec3 color;
     float constant;
+    vec3 color;
     float linear;
     float quadratic;
 };
 
-uniform int numLights;
-uniform PointLight lights[MAX_LIGHTS];
+// shared by all lit shaders, filled by LightUniformBuffer (MAX_LIGHTS has to match)
+layout (std140) uniform Lights {
+    PointLight lights[MAX_LIGHTS];
+    int numLights;
+};
 
 in vec2 TexCoords;
 in vec3 FragPos;
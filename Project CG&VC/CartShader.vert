@@ -1,7 +1,7 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
@@ -12,11 +12,14 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "Packing.GLSL"
+
 void main() {
-    TexCoords = aTexCoords;
+    TexCoords = aTexCoords * uvScale + uvOffset;
+    vec3 position = aPos * positionScale + positionOffset;
 
-    FragPos = vec3(model * vec4(aPos, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    FragPos = vec3(model * vec4(position, 1.0f));
+    Normal = mat3(transpose(inverse(model))) * decodeNormal(aNormal);
     
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    gl_Position = projection * view * model * vec4(position, 1.0f);
 }
\ No newline at end of file
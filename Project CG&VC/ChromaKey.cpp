@@ -1,26 +1,11 @@
 #include "ChromaKey.h"
-#include "stb_image.h"
 
 
 ChromaKey::ChromaKey(unsigned int width, unsigned int height, const char* overlayPath)
     : m_shader(".\\ChromaKey.vert", ".\\ChromaKey.frag"), m_width(width), m_height(height)
 {
     
-    stbi_set_flip_vertically_on_load(true);
-
-    int tw, th, tc;
-    unsigned char* data = stbi_load(overlayPath, &tw, &th, &tc, 4);
-    if (!data) {
-        std::cerr << "Failed to load overlay image: " << overlayPath << "\n" << stbi_failure_reason() << std::endl;
-    }
-    
-    glGenTextures(1, &m_overlayTexture);
-    glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
-    GLenum format = (tc == 4) ? GL_RGBA : GL_RGB;
-    glTexImage2D(GL_TEXTURE_2D, 0, format, tw, th, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    stbi_image_free(data);
+    m_overlayTexture = TextureCache::Get(overlayPath, TextureSettings::Sprite());
 
     InitQuad();
 }
@@ -65,7 +50,7 @@ void ChromaKey::Render() {
 
     m_shader.use();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+    glBindTexture(GL_TEXTURE_2D, m_overlayTexture->id);
     m_shader.setInt("overlayTexture", 0);
 
     glBindVertexArray(m_quadVAO);
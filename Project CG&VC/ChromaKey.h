@@ -2,7 +2,9 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <memory>
 #include "Shader.h"
+#include "TextureCache.h"
 
 class ChromaKey {
 public:
@@ -14,7 +16,7 @@ public:
 
 private:
     void InitQuad();
-    GLuint m_overlayTexture;
+    std::shared_ptr<TextureResource> m_overlayTexture;
     GLuint m_quadVAO, m_quadVBO;
     Shader m_shader;
     unsigned int m_width, m_height;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// The six planes of the view frustum, extracted from projection * view (Gribb & Hartmann).
+// A plane is (normal, d) with the normal pointing into the frustum.
+struct Frustum {
+	glm::vec4 planes[6];
+
+	Frustum() = default;
+
+	explicit Frustum(const glm::mat4& viewProjection) {
+		// rows of the matrix, glm is column major
+		glm::vec4 row[4];
+		for (int i = 0; i < 4; ++i)
+			row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+		planes[0] = row[3] + row[0];	// left
+		planes[1] = row[3] - row[0];	// right
+		planes[2] = row[3] + row[1];	// bottom
+		planes[3] = row[3] - row[1];	// top
+		planes[4] = row[3] + row[2];	// near
+		planes[5] = row[3] - row[2];	// far
+
+		for (auto& plane : planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	// -1 outside, 0 intersecting, 1 completely inside
+	int TestBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+		int result = 1;
+		for (const auto& plane : planes) {
+			glm::vec3 normal(plane);
+			// the corner furthest along the normal, and the one furthest against it
+			glm::vec3 positive(normal.x >= 0.0f ? boxMax.x : boxMin.x, normal.y >= 0.0f ? boxMax.y : boxMin.y, normal.z >= 0.0f ? boxMax.z : boxMin.z);
+			glm::vec3 negative(normal.x >= 0.0f ? boxMin.x : boxMax.x, normal.y >= 0.0f ? boxMin.y : boxMax.y, normal.z >= 0.0f ? boxMin.z : boxMax.z);
+			if (glm::dot(normal, positive) + plane.w < 0.0f)
+				return -1;
+			if (glm::dot(normal, negative) + plane.w < 0.0f)
+				result = 0;
+		}
+		return result;
+	}
+};
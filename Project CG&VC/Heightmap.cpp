@@ -1,4 +1,5 @@
 #include "Heightmap.h"
+#include "AssetLoader.h"
 
 Heightmap::Heightmap(const std::string& heightmapPath, const std::string& texturePath, float yScale, float yShift) 
     : m_heightmapShader(".\\heightmapShader.vert", ".\\heightmapShader.frag")
@@ -12,10 +13,19 @@ Heightmap::Heightmap(const std::string& heightmapPath, const std::string& textur
     std::string rockPath = texturePath + "/rock_cartoon.jpg";
     std::string snowPath = texturePath + "/snow_cartoon.jpg";
 
-    sandTextureID = Utilities::loadTexture(sandPath);
-    grassTextureID = Utilities::loadTexture(grassPath);
-    rockTextureID = Utilities::loadTexture(rockPath);
-    snowTextureID = Utilities::loadTexture(snowPath);
+    sandTexture = Utilities::loadTexture(sandPath);
+    grassTexture = Utilities::loadTexture(grassPath);
+    rockTexture = Utilities::loadTexture(rockPath);
+    snowTexture = Utilities::loadTexture(snowPath);
+}
+
+// starts decoding the heightmap and the terrain textures on the loader threads
+void Heightmap::Prefetch(const std::string& heightmapPath, const std::string& texturePath) {
+    AssetLoader::Get().PrefetchImage(heightmapPath, 0, true);
+    TextureCache::Prefetch(texturePath + "/sand_cartoon.jpg", TextureSettings::Terrain());
+    TextureCache::Prefetch(texturePath + "/grass_cartoon.jpg", TextureSettings::Terrain());
+    TextureCache::Prefetch(texturePath + "/rock_cartoon.jpg", TextureSettings::Terrain());
+    TextureCache::Prefetch(texturePath + "/snow_cartoon.jpg", TextureSettings::Terrain());
 }
 
 Heightmap::~Heightmap() {
@@ -25,8 +35,10 @@ Heightmap::~Heightmap() {
 }
 
 void Heightmap::LoadHeightmap(const std::string& heightmapPath, float yScale, float yShift) {
-    int width, height, nChannels;
-    unsigned char* data = stbi_load(heightmapPath.c_str(), &width, &height, &nChannels, 0);
+    // flipped, like it always was loaded after the (flipped) cart textures
+    std::shared_ptr<const ImageData> image = AssetLoader::Get().TakeImage(heightmapPath, 0, true);
+    int width = image->width, height = image->height, nChannels = image->channels;
+    const unsigned char* data = image->pixels;
     if (!data) {
         std::cerr << "Failed to load heightmap: " << heightmapPath << std::endl;
         return;
@@ -39,7 +51,7 @@ void Heightmap::LoadHeightmap(const std::string& heightmapPath, float yScale, fl
 
     for (unsigned int i = 0; i < height; ++i) {
         for (unsigned int j = 0; j < width; ++j) {
-            unsigned char* texel = data + (j + width * i) * nChannels;
+            const unsigned char* texel = data + (j + width * i) * nChannels;
             unsigned char y = texel[0];
 
             // Vertex positions
@@ -70,8 +82,6 @@ void Heightmap::LoadHeightmap(const std::string& heightmapPath, float yScale, fl
 
     numStrips = height - 1;
     numVertsPerStrip = width * 2;
-
-    stbi_image_free(data);
 }
 
 glm::vec3 Heightmap::computeNormal(int x, int z, int width, int height, const std::vector<unsigned char >& heightData, float yScale, float yShift) {
@@ -94,21 +104,15 @@ void Heightmap::GenerateBuffers() {
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
 
+    std::vector<PackedVertex> packed;
+    m_quantization = VertexPacking::Pack(vertices.data(), vertices.size() / 8, 8, 0, 5, 3, packed);
+
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Texture coordinates
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
 
-    // Normal
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // position, normal and uv
+    VertexLayout::Apply();
 
     glGenBuffers(1, &EBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
@@ -128,15 +132,16 @@ void Heightmap::Render(const glm::mat4& projection, const glm::mat4& view, const
     m_heightmapShader.setMat4("projection", projection);
     m_heightmapShader.setMat4("view", view);
     m_heightmapShader.setMat4("model", model);
+    VertexLayout::SetUniforms(m_heightmapShader, m_quantization);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, sandTextureID);
+    glBindTexture(GL_TEXTURE_2D, sandTexture->id);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, grassTextureID);
+    glBindTexture(GL_TEXTURE_2D, grassTexture->id);
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, rockTextureID);
+    glBindTexture(GL_TEXTURE_2D, rockTexture->id);
     glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, snowTextureID);
+    glBindTexture(GL_TEXTURE_2D, snowTexture->id);
 
     glBindVertexArray(VAO);
     for (unsigned int strip = 0; strip < numStrips; ++strip) {
@@ -8,6 +8,7 @@
 #include "Shader.h"
 #include "Light.h"
 #include "Utilities.h"
+#include "VertexLayout.h"
 
 #include <iostream>
 #include <vector>
@@ -16,6 +17,7 @@
 class Heightmap {
 public:
 	Heightmap(const std::string& heightmapPath, const std::string& texturePath, float yScale, float yShift);
+	static void Prefetch(const std::string& heightmapPath, const std::string& texturePath);
 
 	~Heightmap();
 
@@ -33,8 +35,9 @@ private:
 
 	Shader m_heightmapShader;
 	unsigned int VAO, VBO, EBO;
-	unsigned int sandTextureID, grassTextureID, rockTextureID, snowTextureID;
-	std::vector<float> vertices;
+	std::shared_ptr<TextureResource> sandTexture, grassTexture, rockTexture, snowTexture;
+	std::vector<float> vertices;	// position, uv, normal as floats for GetHeightAt, the GPU gets them packed
 	std::vector<unsigned int> indices;
+	VertexQuantization m_quantization;
 	unsigned int numStrips, numVertsPerStrip;
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in vec2 aTexCoord;	// the packed vertices of the models, the normal (1) isn't used
 
 out vec2 TexCoord;
 out float Height;
@@ -9,8 +9,11 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "Packing.GLSL"
+
 void main() {
-    TexCoord = aTexCoord;
-    Height = aPos.y;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = aPos * positionScale + positionOffset;
+    TexCoord = aTexCoord * uvScale + uvOffset;
+    Height = position.y;
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
\ No newline at end of file
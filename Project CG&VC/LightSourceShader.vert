@@ -8,8 +8,10 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "Packing.GLSL"
+
 void main() {
-	TexCoords = aTexCoords;
+	TexCoords = aTexCoords * uvScale + uvOffset;
 
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	gl_Position = projection * view * model * vec4(aPos * positionScale + positionOffset, 1.0f);
 }
\ No newline at end of file
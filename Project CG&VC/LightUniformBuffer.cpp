@@ -0,0 +1,35 @@
+#include "LightUniformBuffer.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+
+LightUniformBuffer::LightUniformBuffer() : m_block() {
+    glGenBuffers(1, &m_UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &m_block, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // stays bound for the whole program
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, m_UBO);
+}
+
+LightUniformBuffer::~LightUniformBuffer() {
+    glDeleteBuffers(1, &m_UBO);
+}
+
+void LightUniformBuffer::Update(const std::vector<PointLight>& lights) {
+    int count = std::min(static_cast<int>(lights.size()), MAX_LIGHTS);
+    for (int i = 0; i < count; ++i) {
+        LightData& data = m_block.lights[i];
+        data.position = lights[i].position;
+        data.constant = lights[i].constant;
+        data.color = lights[i].color;
+        data.linear = lights[i].linear;
+        data.quadratic = lights[i].quadratic;
+    }
+    m_block.numLights = count;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &m_block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
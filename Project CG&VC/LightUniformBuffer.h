@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Light.h"
+
+/*
+* All point lights in one std140 uniform buffer, shared by every lit shader
+* containts:
+*		- the buffer is bound to BINDING_POINT once, a shader links its "Lights" block to it with Shader::bindUniformBlock
+*		- Update uploads all lights with one glBufferSubData per frame
+*		- the layout below has to match the Lights block in CartShader.frag and LightingShader.frag
+*/
+class LightUniformBuffer {
+public:
+	static const unsigned int BINDING_POINT = 0;
+	static const int MAX_LIGHTS = 8;
+
+	LightUniformBuffer();
+	~LightUniformBuffer();
+
+	LightUniformBuffer(const LightUniformBuffer&) = delete;
+	LightUniformBuffer& operator=(const LightUniformBuffer&) = delete;
+
+	void Update(const std::vector<PointLight>& lights);
+
+private:
+	// std140: a vec3 followed by a float shares one 16 byte slot, a struct is rounded up to 16 bytes
+	struct LightData {
+		glm::vec3 position;
+		float constant;
+		glm::vec3 color;
+		float linear;
+		float quadratic;
+		float padding[3];
+	};
+
+	struct LightBlock {
+		LightData lights[MAX_LIGHTS];
+		int numLights;
+		int padding[3];
+	};
+
+	static_assert(sizeof(LightData) == 48, "LightData doesn't match the std140 layout");
+	static_assert(sizeof(LightBlock) == 48 * MAX_LIGHTS + 16, "LightBlock doesn't match the std140 layout");
+
+	unsigned int m_UBO = 0;
+	LightBlock m_block;
+};
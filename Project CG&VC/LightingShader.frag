@@ -1,17 +1,20 @@
 // This shader is used as a template for objects that need to be affected by lighting
 #version 330 core
-#define MAX_LIGHTS 4
+#define MAX_LIGHTS 8
 
 struct PointLight {
     vec3 position;
-    vec3 color;
     float constant;
+    vec3 color;
     float linear;
     float quadratic;
 };
 
-uniform int numLights;
-uniform PointLight lights[MAX_LIGHTS];
+// shared by all lit shaders, filled by LightUniformBuffer (MAX_LIGHTS has to match)
+layout (std140) uniform Lights {
+    PointLight lights[MAX_LIGHTS];
+    int numLights;
+};
 
 in vec3 FragPos;
 in vec3 Normal;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+* Read-only memory mapped file, the OS pages the data in when it is touched
+* containts:
+*		- CreateFileMapping/MapViewOfFile on Windows, mmap everywhere else
+*		- the mapping is released when the object is destroyed, so it can't be copied
+*/
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const unsigned char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+};
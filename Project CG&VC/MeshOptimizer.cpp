@@ -0,0 +1,607 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <queue>
+#include <glm/glm.hpp>
+
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation": every step the triangle with the highest
+// score is emitted, a vertex scores for its position in a simulated LRU cache and for having few
+// triangles left (so lonely triangles are not left behind)
+namespace {
+    const int FORSYTH_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else {
+                float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // triangles per vertex, as one flat array
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++remaining[indices[i]];
+
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k)
+            vertexTriangles[filled[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint32_t> cache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t nextUnemitted = 0;
+    long best = -1;
+    while (output.size() < triangleCount * 3) {
+        // nothing good in the cache: the best triangle of the whole mesh (only happens between islands)
+        if (best < 0) {
+            float bestScore = -1.0f;
+            while (nextUnemitted < triangleCount && emitted[nextUnemitted])
+                ++nextUnemitted;
+            for (size_t t = nextUnemitted; t < triangleCount; ++t) {
+                if (!emitted[t] && triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = static_cast<long>(t);
+                }
+            }
+        }
+
+        // emit it and take its triangle out of the vertex lists
+        emitted[best] = true;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = indices[best * 3 + k];
+            output.push_back(v);
+
+            unsigned int* begin = &vertexTriangles[firstTriangle[v]];
+            unsigned int* end = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, static_cast<unsigned int>(best)), end - 1);
+            --remaining[v];
+
+            // move the vertex to the front of the cache
+            auto cached = std::find(cache.begin(), cache.end(), v);
+            if (cached != cache.end())
+                cache.erase(cached);
+            cache.insert(cache.begin(), v);
+        }
+
+        // rescore the vertices in the cache (and the ones that just fell out) and their triangles
+        for (size_t i = 0; i < cache.size(); ++i) {
+            uint32_t v = cache[i];
+            cachePosition[v] = i < static_cast<size_t>(FORSYTH_CACHE_SIZE) ? static_cast<int>(i) : -1;
+            float newScore = vertexScore(cachePosition[v], remaining[v]);
+            float change = newScore - score[v];
+            score[v] = newScore;
+            for (unsigned int j = 0; j < remaining[v]; ++j)
+                triangleScore[vertexTriangles[firstTriangle[v] + j]] += change;
+        }
+        if (cache.size() > static_cast<size_t>(FORSYTH_CACHE_SIZE))
+            cache.resize(FORSYTH_CACHE_SIZE);
+
+        // the next triangle comes from the cache
+        best = -1;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (unsigned int j = 0; j < remaining[v]; ++j) {
+                unsigned int t = vertexTriangles[firstTriangle[v] + j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = static_cast<long>(t);
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+// meshoptimizer style: the cache optimised order is cut into clusters, which are sorted by how much they
+// face away from the center of the mesh; a small cluster size keeps most of the cache gain
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t stride, size_t clusterTriangles) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < clusterTriangles * 2)
+        return;
+
+    auto position = [&](uint32_t v) {
+        const float* p = vertices + size_t(v) * stride;
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    glm::vec3 meshCenter(0.0f);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        meshCenter += position(indices[i]);
+    meshCenter /= static_cast<float>(triangleCount * 3);
+
+    struct Cluster {
+        size_t first;
+        size_t count;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    for (size_t first = 0; first < triangleCount; first += clusterTriangles) {
+        Cluster cluster = { first, std::min(clusterTriangles, triangleCount - first), 0.0f };
+
+        glm::vec3 center(0.0f), normal(0.0f);
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; ++t) {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            glm::vec3 areaNormal = glm::cross(b - a, c - a);	// length is twice the area
+            center += (a + b + c) * (glm::length(areaNormal) / 3.0f);
+            normal += areaNormal;
+        }
+        float area = glm::length(normal);
+        float weight = 0.0f;
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; ++t) {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            weight += glm::length(glm::cross(b - a, c - a));
+        }
+        if (weight > 0.0f && area > 0.0f)
+            cluster.sortKey = glm::dot(center / weight - meshCenter, normal / area);
+        clusters.push_back(cluster);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    for (const Cluster& cluster : clusters)
+        output.insert(output.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+    std::copy(output.begin(), output.end(), indices);
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(std::vector<float>& vertices, size_t stride, uint32_t* indices, size_t indexCount) {
+    size_t vertexCount = vertices.size() / stride;
+    const uint32_t unused = 0xffffffffu;
+    std::vector<uint32_t> remap(vertexCount, unused);
+
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& target = remap[indices[i]];
+        if (target == unused) {
+            target = next++;
+            reordered.insert(reordered.end(), vertices.begin() + size_t(indices[i]) * stride, vertices.begin() + (size_t(indices[i]) + 1) * stride);
+        }
+        indices[i] = target;
+    }
+
+    vertices.swap(reordered);
+    return next;
+}
+
+float MeshOptimizer::ComputeACMR(const uint32_t* indices, size_t indexCount, unsigned int cacheSize) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+
+    // FIFO, like the post-transform cache of most GPUs: a hit doesn't move the vertex
+    std::vector<uint32_t> cache(cacheSize, 0xffffffffu);
+    size_t head = 0;
+    size_t misses = 0;
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end()) {
+            cache[head] = indices[i];
+            head = (head + 1) % cacheSize;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+namespace {
+    // plane quadric, the symmetric 4x4 matrix as 10 values
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        void AddPlane(const glm::dvec3& n, double d, double weight) {
+            a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+            b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+            c2 += weight * n.z * n.z; cd += weight * n.z * d;
+            d2 += weight * d * d;
+        }
+
+        void Add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        }
+
+        // sum of the squared distances of p to the planes
+        double Error(const glm::dvec3& p) const {
+            return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+                + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+                + c2 * p.z * p.z + 2 * cd * p.z + d2;
+        }
+    };
+
+    // one attribute (a normal or uv component) of a vertex, Hoppe's "New Quadric Metric": a triangle
+    // interpolates the attribute on its plane as g . p + d, the quadric sums (g . p + d - a)^2 over the
+    // triangles, a symmetric 5x5 matrix over (x, y, z, a, 1) as 15 values
+    struct AttributeQuadric {
+        double m[15] = {};
+
+        void AddGradient(const glm::dvec3& gradient, double offset, double weight) {
+            const double h[5] = { gradient.x, gradient.y, gradient.z, -1.0, offset };
+            int k = 0;
+            for (int i = 0; i < 5; ++i) {
+                for (int j = i; j < 5; ++j)
+                    m[k++] += weight * h[i] * h[j];
+            }
+        }
+
+        void Add(const AttributeQuadric& q) {
+            for (int k = 0; k < 15; ++k)
+                m[k] += q.m[k];
+        }
+
+        // sum of the squared differences between a at p and what the triangles interpolate there
+        double Error(const glm::dvec3& p, double a) const {
+            const double u[5] = { p.x, p.y, p.z, a, 1.0 };
+            double error = 0.0;
+            int k = 0;
+            for (int i = 0; i < 5; ++i) {
+                for (int j = i; j < 5; ++j)
+                    error += (i == j ? 1.0 : 2.0) * m[k++] * u[i] * u[j];
+            }
+            return error;
+        }
+    };
+
+    // what a squared attribute difference costs against a squared distance relative to the mesh size: a normal
+    // that is off by 0.1 (about 6 degrees) weighs like 1% of the mesh size; the uvs pick colours from a palette,
+    // a uv that slides into the next colour has to cost more than a visible bump
+    const size_t ATTRIBUTE_COUNT = 5;
+    const double ATTRIBUTE_WEIGHTS[ATTRIBUTE_COUNT] = { 0.01, 0.01, 0.01, 1.0, 1.0 };
+
+    struct Collapse {
+        double cost;
+        uint32_t from, to;
+        unsigned int fromVersion, toVersion;
+
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+}
+
+// The topology is built on the vertices welded by position, so UV seams and hard edges don't cut the
+// surface apart. A collapse moves every copy (wedge) of one position onto the matching copy of a neighbour
+// position, so no vertices are made and the LODs share the vertex buffer of the full mesh; what that does
+// to the normals and uvs is priced in by the attribute quadrics of the copies. Open borders stay in place.
+std::vector<uint32_t> MeshOptimizer::Simplify(const uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride,
+    size_t targetIndexCount, float targetError, float meshExtent, float* error) {
+    std::vector<uint32_t> result(indices, indices + indexCount - indexCount % 3);
+    if (error)
+        *error = 0.0f;
+    if (result.size() <= targetIndexCount || meshExtent <= 0.0f)
+        return result;
+
+    std::vector<glm::dvec3> positions(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        positions[v] = glm::dvec3(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+    size_t attributeCount = stride >= 3 + ATTRIBUTE_COUNT ? ATTRIBUTE_COUNT : 0;
+    auto attribute = [&](uint32_t v, size_t c) {
+        return double(vertices[v * stride + 3 + c]);
+    };
+
+    // weld[v] is the vertex that stands for all vertices at the position of v
+    std::vector<uint32_t> weld(vertexCount);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            order[v] = static_cast<uint32_t>(v);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            const glm::dvec3& pa = positions[a];
+            const glm::dvec3& pb = positions[b];
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        });
+        for (size_t i = 0; i < vertexCount; ++i)
+            weld[order[i]] = i > 0 && positions[order[i]] == positions[order[i - 1]] ? weld[order[i - 1]] : order[i];
+    }
+
+    // triangles with two corners at the same position have no area and no place in the welded topology
+    size_t triangleCount = 0;
+    for (size_t t = 0; t < result.size() / 3; ++t) {
+        uint32_t a = weld[result[t * 3]], b = weld[result[t * 3 + 1]], c = weld[result[t * 3 + 2]];
+        if (a != b && b != c && a != c) {
+            std::copy(result.begin() + t * 3, result.begin() + t * 3 + 3, result.begin() + triangleCount * 3);
+            ++triangleCount;
+        }
+    }
+    result.resize(triangleCount * 3);
+
+    // the copies of every position that are used, and the positions on an edge that doesn't have exactly
+    // two triangles (an open border), which stay where they are
+    std::vector<std::vector<uint32_t>> wedges(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<bool> used(vertexCount, false);
+        std::vector<uint64_t> edges;
+        edges.reserve(triangleCount * 3);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = result[t * 3 + k];
+                if (!used[v])
+                    wedges[weld[v]].push_back(v);
+                used[v] = true;
+                uint32_t a = weld[v], b = weld[result[t * 3 + (k + 1) % 3]];
+                edges.push_back(uint64_t(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            if (j - i != 2) {
+                locked[edges[i] >> 32] = true;
+                locked[edges[i] & 0xffffffffu] = true;
+            }
+            i = j;
+        }
+    }
+
+    // the triangles around every position and the quadric of their planes, and per copy the quadrics of
+    // its attributes over the triangles it is used in
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<AttributeQuadric> attributeQuadrics(vertexCount * attributeCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* triangle = &result[t * 3];
+        const glm::dvec3& a = positions[triangle[0]];
+        glm::dvec3 edge1 = positions[triangle[1]] - a, edge2 = positions[triangle[2]] - a;
+        glm::dvec3 normal = glm::cross(edge1, edge2);
+        double area = glm::length(normal);
+        for (int k = 0; k < 3; ++k)
+            vertexTriangles[weld[triangle[k]]].push_back(static_cast<uint32_t>(t));
+        if (area <= 0.0)
+            continue;
+        for (int k = 0; k < 3; ++k)
+            quadrics[weld[triangle[k]]].AddPlane(normal / area, -glm::dot(normal / area, a), area);
+
+        // the gradient g in the plane of the triangle with g . edge1 = a1 - a0 and g . edge2 = a2 - a0
+        glm::dvec3 along1 = glm::cross(edge2, normal) / (area * area), along2 = glm::cross(normal, edge1) / (area * area);
+        for (size_t c = 0; c < attributeCount; ++c) {
+            double a0 = attribute(triangle[0], c);
+            glm::dvec3 gradient = (attribute(triangle[1], c) - a0) * along1 + (attribute(triangle[2], c) - a0) * along2;
+            double offset = a0 - glm::dot(gradient, a);
+            for (int k = 0; k < 3; ++k)
+                attributeQuadrics[triangle[k] * attributeCount + c].AddGradient(gradient, offset, area);
+        }
+    }
+
+    // the copy of to that every copy of from turns into: one it shares a triangle with, so the attributes
+    // run on across the collapsed edge, otherwise the one with the closest attributes
+    auto matchWedges = [&](uint32_t from, uint32_t to, std::vector<uint32_t>& targets) {
+        targets.clear();
+        for (uint32_t wedge : wedges[from]) {
+            uint32_t best = wedges[to][0];
+            bool bestConnected = false;
+            double bestDistance = 0.0;
+            for (uint32_t candidate : wedges[to]) {
+                bool connected = false;
+                for (uint32_t t : vertexTriangles[from]) {
+                    const uint32_t* triangle = &result[t * 3];
+                    bool hasWedge = triangle[0] == wedge || triangle[1] == wedge || triangle[2] == wedge;
+                    bool hasCandidate = triangle[0] == candidate || triangle[1] == candidate || triangle[2] == candidate;
+                    connected = connected || (hasWedge && hasCandidate);
+                }
+                double distance = 0.0;
+                for (size_t c = 0; c < attributeCount; ++c)
+                    distance += (attribute(wedge, c) - attribute(candidate, c)) * (attribute(wedge, c) - attribute(candidate, c));
+                if (candidate == wedges[to][0] || (connected && !bestConnected) || (connected == bestConnected && distance < bestDistance)) {
+                    best = candidate;
+                    bestConnected = connected;
+                    bestDistance = distance;
+                }
+            }
+            targets.push_back(best);
+        }
+    };
+
+    // errors are relative to the size of the mesh, the quadrics hold squared distances weighted by area
+    double scale = 1.0 / meshExtent;
+    double maxCost = double(targetError) * targetError;
+    std::vector<bool> removed(triangleCount, false);
+    std::vector<unsigned int> version(vertexCount, 0);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+    std::vector<uint32_t> targets;
+
+    auto triangleArea = [&](uint32_t t) {
+        const uint32_t* triangle = &result[t * 3];
+        return glm::length(glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]));
+    };
+
+    auto cost = [&](uint32_t from, uint32_t to) {
+        Quadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        double area = 0.0;
+        for (uint32_t t : vertexTriangles[from])
+            area += triangleArea(t);
+        for (uint32_t t : vertexTriangles[to])
+            area += triangleArea(t);
+        if (area <= 0.0)
+            return 0.0;
+
+        // the copies of from take the attributes of their targets, the ones of to keep theirs
+        const glm::dvec3& p = positions[to];
+        double attributeError = 0.0;
+        matchWedges(from, to, targets);
+        for (size_t i = 0; i < targets.size(); ++i) {
+            for (size_t c = 0; c < attributeCount; ++c)
+                attributeError += ATTRIBUTE_WEIGHTS[c] * attributeQuadrics[wedges[from][i] * attributeCount + c].Error(p, attribute(targets[i], c));
+        }
+        for (uint32_t wedge : wedges[to]) {
+            for (size_t c = 0; c < attributeCount; ++c)
+                attributeError += ATTRIBUTE_WEIGHTS[c] * attributeQuadrics[wedge * attributeCount + c].Error(p, attribute(wedge, c));
+        }
+        // the average squared distance to the planes in mesh units, plus the average squared attribute error
+        return (std::max(q.Error(p), 0.0) * scale * scale + std::max(attributeError, 0.0)) / area;
+    };
+
+    auto pushCollapses = [&](uint32_t v) {
+        for (uint32_t t : vertexTriangles[v]) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t other = weld[result[t * 3 + k]];
+                if (other == v)
+                    continue;
+                if (!locked[v])
+                    queue.push({ cost(v, other), v, other, version[v], version[other] });
+                if (!locked[other])
+                    queue.push({ cost(other, v), other, v, version[other], version[v] });
+            }
+        }
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = weld[result[t * 3 + k]], b = weld[result[t * 3 + (k + 1) % 3]];
+            if (!locked[a])
+                queue.push({ cost(a, b), a, b, 0, 0 });
+            if (!locked[b])
+                queue.push({ cost(b, a), b, a, 0, 0 });
+        }
+    }
+
+    auto hasPosition = [&](const uint32_t* triangle, uint32_t position) {
+        return weld[triangle[0]] == position || weld[triangle[1]] == position || weld[triangle[2]] == position;
+    };
+
+    size_t liveTriangles = triangleCount;
+    double acceptedCost = 0.0;
+    while (!queue.empty() && liveTriangles * 3 > targetIndexCount) {
+        Collapse collapse = queue.top();
+        queue.pop();
+        if (collapse.cost > maxCost)
+            break;
+        if (collapse.fromVersion != version[collapse.from] || collapse.toVersion != version[collapse.to] || vertexTriangles[collapse.from].empty())
+            continue;
+
+        // the two positions may only share the neighbours across the collapsed edge, otherwise the surface pinches
+        std::vector<uint32_t> fromNeighbours, toNeighbours;
+        size_t sharedTriangles = 0;
+        for (uint32_t t : vertexTriangles[collapse.from]) {
+            for (int k = 0; k < 3; ++k)
+                fromNeighbours.push_back(weld[result[t * 3 + k]]);
+            if (hasPosition(&result[t * 3], collapse.to))
+                ++sharedTriangles;
+        }
+        for (uint32_t t : vertexTriangles[collapse.to]) {
+            for (int k = 0; k < 3; ++k)
+                toNeighbours.push_back(weld[result[t * 3 + k]]);
+        }
+        std::sort(fromNeighbours.begin(), fromNeighbours.end());
+        fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+        std::sort(toNeighbours.begin(), toNeighbours.end());
+        toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+        std::vector<uint32_t> common;
+        std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(), std::back_inserter(common));
+        // common holds both positions of the edge and one opposite position per shared triangle
+        if (sharedTriangles == 0 || common.size() != sharedTriangles + 2)
+            continue;
+
+        // a triangle that doesn't go away must not flip or fold over
+        bool flips = false;
+        for (uint32_t t : vertexTriangles[collapse.from]) {
+            const uint32_t* triangle = &result[t * 3];
+            if (hasPosition(triangle, collapse.to))
+                continue;
+            glm::dvec3 corners[3], moved[3];
+            for (int k = 0; k < 3; ++k) {
+                corners[k] = positions[triangle[k]];
+                moved[k] = weld[triangle[k]] == collapse.from ? positions[collapse.to] : corners[k];
+            }
+            glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            double afterLength = glm::length(after), beforeLength = glm::length(before);
+            if (afterLength <= 0.0 || beforeLength <= 0.0 || glm::dot(before, after) < 0.25 * beforeLength * afterLength) {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        // move the triangles over, every copy of from onto its target; the ones on the collapsed edge disappear
+        matchWedges(collapse.from, collapse.to, targets);
+        for (uint32_t t : vertexTriangles[collapse.from]) {
+            uint32_t* triangle = &result[t * 3];
+            if (hasPosition(triangle, collapse.to)) {
+                removed[t] = true;
+                --liveTriangles;
+                for (int k = 0; k < 3; ++k) {
+                    if (weld[triangle[k]] == collapse.from)
+                        continue;
+                    std::vector<uint32_t>& list = vertexTriangles[weld[triangle[k]]];
+                    list.erase(std::find(list.begin(), list.end(), t));
+                }
+            }
+            else {
+                for (int k = 0; k < 3; ++k) {
+                    if (weld[triangle[k]] == collapse.from)
+                        triangle[k] = targets[std::find(wedges[collapse.from].begin(), wedges[collapse.from].end(), triangle[k]) - wedges[collapse.from].begin()];
+                }
+                vertexTriangles[collapse.to].push_back(t);
+            }
+        }
+        for (size_t i = 0; i < targets.size(); ++i) {
+            for (size_t c = 0; c < attributeCount; ++c)
+                attributeQuadrics[targets[i] * attributeCount + c].Add(attributeQuadrics[wedges[collapse.from][i] * attributeCount + c]);
+        }
+        wedges[collapse.from].clear();
+        vertexTriangles[collapse.from].clear();
+        quadrics[collapse.to].Add(quadrics[collapse.from]);
+        acceptedCost = std::max(acceptedCost, collapse.cost);
+
+        // only the quadrics of the target changed, its collapses are queued again
+        ++version[collapse.from];
+        ++version[collapse.to];
+        pushCollapses(collapse.to);
+    }
+
+    std::vector<uint32_t> simplified;
+    simplified.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!removed[t])
+            simplified.insert(simplified.end(), result.begin() + t * 3, result.begin() + t * 3 + 3);
+    }
+    if (error)
+        *error = static_cast<float>(std::sqrt(acceptedCost));
+    return simplified;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Reorders the triangles and vertices of an indexed triangle list for the GPU, done once when a model is baked
+* containts:
+*		- vertex cache order (Forsyth): triangles that share vertices are drawn close after each other
+*		- overdraw order: clusters of triangles that face outwards are drawn first, so more pixels fail the depth test
+*		- vertex fetch order: vertices in the order they are first used, unused vertices are dropped
+*		- a FIFO post-transform cache simulator, the ACMR (cache misses per triangle) shows what the reorder gained
+*		- simplification by quadric error edge collapses (Garland and Heckbert, attributes after Hoppe) for the levels of detail
+*/
+class MeshOptimizer {
+public:
+	static const unsigned int SIMULATED_CACHE_SIZE = 16;
+
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// positions: the first 3 floats of every vertex, stride in floats
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t stride, size_t clusterTriangles = 64);
+
+	// reorders vertices (stride floats each) and remaps the indices, returns the new vertex count
+	static size_t OptimizeVertexFetch(std::vector<float>& vertices, size_t stride, uint32_t* indices, size_t indexCount);
+
+	// new indices into the same vertices with at most targetIndexCount indices, as far as that is possible
+	// without moving the surface more than targetError (relative to the size of the mesh); vertices of 8 or more
+	// floats carry the normal and uv after the position, UV seams and hard edges are collapsed with what they
+	// cost in normals and uvs, open borders are kept where they are. error is set to the largest error that was accepted
+	static std::vector<uint32_t> Simplify(const uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride,
+		size_t targetIndexCount, float targetError, float meshExtent, float* error = nullptr);
+
+	// average cache misses per triangle, 3 is no reuse at all and 0.5 the best a regular grid can do
+	static float ComputeACMR(const uint32_t* indices, size_t indexCount, unsigned int cacheSize = SIMULATED_CACHE_SIZE);
+};
@@ -0,0 +1,119 @@
+// Test for the MeshOptimizer, without a GPU: the FIFO cache simulator (ComputeACMR) has to show fewer
+// cache misses after the reorder than in the order the triangles came in, and every model has to get
+// coarser levels of detail out of Simplify
+//
+// usage: MeshOptimizerTest [model files...]   (default: the scenery and cart models, returns 0 when every mesh improves)
+// A shuffled grid checks the reorder on its own, the models check the whole import of ModelFile.
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "ModelFile.h"
+
+static const size_t GRID_SIZE = 100;		// vertices per side
+static const float GRID_MAX_ACMR = 1.0f;	// a good order gets close to 0.5 on a grid, the shuffled one is close to 3
+
+// the triangle with its smallest index first, so the same triangle always compares equal
+static std::array<uint32_t, 3> canonical(const uint32_t* triangle) {
+	int first = 0;
+	for (int i = 1; i < 3; ++i) {
+		if (triangle[i] < triangle[first])
+			first = i;
+	}
+	return { triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3] };
+}
+
+static std::vector<std::array<uint32_t, 3>> sortedTriangles(const std::vector<uint32_t>& indices) {
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		triangles.push_back(canonical(&indices[i]));
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// a flat grid whose triangles are drawn in random order, the worst case for the vertex cache
+static bool checkGrid() {
+	std::vector<float> vertices;
+	for (size_t z = 0; z < GRID_SIZE; ++z) {
+		for (size_t x = 0; x < GRID_SIZE; ++x) {
+			float vertex[8] = { static_cast<float>(x), 0.0f, static_cast<float>(z), 0.0f, 1.0f, 0.0f, 0.0f, 0.0f };
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+	}
+
+	std::vector<std::array<uint32_t, 3>> quads;
+	for (size_t z = 0; z + 1 < GRID_SIZE; ++z) {
+		for (size_t x = 0; x + 1 < GRID_SIZE; ++x) {
+			uint32_t a = static_cast<uint32_t>(z * GRID_SIZE + x);
+			quads.push_back({ a, a + static_cast<uint32_t>(GRID_SIZE), a + 1 });
+			quads.push_back({ a + 1, a + static_cast<uint32_t>(GRID_SIZE), a + static_cast<uint32_t>(GRID_SIZE) + 1 });
+		}
+	}
+	srand(1234);
+	for (size_t i = quads.size() - 1; i > 0; --i)
+		std::swap(quads[i], quads[rand() % (i + 1)]);
+
+	std::vector<uint32_t> indices;
+	for (const auto& triangle : quads)
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	std::vector<uint32_t> source = indices;
+
+	float sourceACMR = MeshOptimizer::ComputeACMR(indices.data(), indices.size());
+	MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), GRID_SIZE * GRID_SIZE);
+	float cacheACMR = MeshOptimizer::ComputeACMR(indices.data(), indices.size());
+	MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), 8);
+	float overdrawACMR = MeshOptimizer::ComputeACMR(indices.data(), indices.size());
+
+	// only the order may change, not the triangles or their winding
+	bool sameTriangles = sortedTriangles(indices) == sortedTriangles(source);
+	bool passed = sameTriangles && cacheACMR < sourceACMR && cacheACMR <= GRID_MAX_ACMR && overdrawACMR < sourceACMR;
+	std::cout << (passed ? "ok      " : "FAILED  ") << "shuffled grid (" << indices.size() / 3 << " triangles, ACMR " << sourceACMR
+		<< " -> " << cacheACMR << " vertex cache, " << overdrawACMR << " with overdraw" << (sameTriangles ? "" : ", triangles changed") << ")" << std::endl;
+	return passed;
+}
+
+// the full import: the ACMR of the order in the file against the one that is baked, and the levels of detail
+static bool checkModel(const std::string& path) {
+	ModelMeshData data;
+	if (!ModelFile::Import(path, data)) {
+		std::cout << "FAILED  " << path << " can't be imported" << std::endl;
+		return false;
+	}
+
+	ModelMeshView view = ModelFile::View(data);
+	bool passed = data.optimizedACMR < data.sourceACMR && view.lodCount > 1;
+	std::cout << (passed ? "ok      " : "FAILED  ") << path << " (ACMR " << data.sourceACMR << " -> " << data.optimizedACMR << ", triangles per LOD";
+	for (uint32_t lod = 0; lod < view.lodCount; ++lod)
+		std::cout << (lod == 0 ? " " : "/") << ModelFile::TriangleCount(view, lod);
+	std::cout << ")" << std::endl;
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> models;
+	for (int i = 1; i < argc; ++i)
+		models.push_back(argv[i]);
+	if (models.empty()) {
+		models = {
+			".\\models\\scenery\\tree.fbx",
+			".\\models\\scenery\\boat-row-small.fbx",
+			".\\models\\scenery\\ship-medium.fbx",
+			".\\models\\scenery\\ship-wreck.fbx",
+			".\\models\\scenery\\tower-complete-large.fbx",
+			".\\models\\scenery\\cannon-mobile.fbx",
+			".\\models\\cart\\coaster-train-front.fbx",
+		};
+	}
+
+	bool passed = checkGrid();
+	for (const std::string& model : models)
+		passed = checkModel(model) && passed;
+
+	std::cout << (passed ? "All meshes improve" : "ERROR::MESHOPTIMIZERTEST::The optimised order doesn't beat the source order or a model has no levels of detail") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -1,161 +1,208 @@
 #include "Model.h"
 #include <glad/glad.h>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include "stb_image.h"
+#include "AssetLoader.h"
+#include "VertexLayout.h"
+
+// a level is used while the bounding sphere's diameter covers at least this much of the screen height, below it the next one
+const float Model::LOD_SCREEN_SIZES[Model::MAX_LODS] = { 0.25f, 0.1f, 0.04f, 0.0f };
+
+Model::Model(const std::string& path)
+    : m_resource(ModelCache::Get(path)) {
+}
+
+void Model::Prefetch(const std::string& path) {
+    AssetLoader::Get().PrefetchModel(path);
+}
+
+// the AssetLoader maps the baked .meshb next to the file while it belongs to the same source, otherwise
+// it imports the file with Assimp and bakes it for the next start; both happen on a loader thread
+std::shared_ptr<ModelResource> Model::Import(const std::string& path) {
+    std::shared_ptr<ModelResource> resource = std::make_shared<ModelResource>();
+    resource->path = path;
 
-Model::Model(const std::string& path) {
     // Extract directory from path
     size_t lastSlash = path.find_last_of("/\\");
-    m_directory = (lastSlash == std::string::npos) ? "" : path.substr(0, lastSlash + 1);
-
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path,
-        aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_PreTransformVertices);
-
-    if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
-        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-        VAO = VBO = EBO = 0;
-        indexCount = 0;
-        return;
-    }
+    std::string directory = (lastSlash == std::string::npos) ? "" : path.substr(0, lastSlash + 1);
 
-    // Only load the first mesh for simplicity
-    aiMesh* mesh = scene->mMeshes[0];
-
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-
-    for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-        // Position
-        vertices.push_back(mesh->mVertices[i].x);
-        vertices.push_back(mesh->mVertices[i].y);
-        vertices.push_back(mesh->mVertices[i].z);
-        // Normal
-        if (mesh->HasNormals()) {
-            vertices.push_back(mesh->mNormals[i].x);
-            vertices.push_back(mesh->mNormals[i].y);
-            vertices.push_back(mesh->mNormals[i].z);
-        }
-        else {
-            vertices.push_back(0.0f);
-            vertices.push_back(0.0f);
-            vertices.push_back(0.0f);
-        }
-        // TexCoords
-        if (mesh->HasTextureCoords(0)) {
-            vertices.push_back(mesh->mTextureCoords[0][i].x);
-            vertices.push_back(mesh->mTextureCoords[0][i].y);
-        }
-        else {
-            vertices.push_back(0.0f);
-            vertices.push_back(0.0f);
-        }
-    }
+    std::shared_ptr<ModelPayload> payload = AssetLoader::Get().TakeModel(path);
+    if (!payload->valid)
+        return resource;
 
-    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; ++j)
-            indices.push_back(face.mIndices[j]);
+    {
+        AssetUploadTimer timer(path);
+        Upload(*resource, payload->view, directory);
     }
-    indexCount = static_cast<unsigned int>(indices.size());
+    std::cout << (payload->fromBakedFile ? "Loaded baked model " : "Imported model ") << path << ": " << payload->view.subMeshCount
+        << " meshes, " << resource->lods[0].batches.size() << " material batches, " << (resource->indexType == GL_UNSIGNED_SHORT ? 16 : 32)
+        << " bit indices, triangles per LOD";
+    for (size_t lod = 0; lod < resource->lods.size(); ++lod)
+        std::cout << (lod == 0 ? " " : "/") << resource->lods[lod].triangles;
+    if (!payload->fromBakedFile)
+        std::cout << ", ACMR " << payload->imported.sourceACMR << " -> " << payload->imported.optimizedACMR;
+    std::cout << std::endl;
+    return resource;
+}
+
+// the vertices and indices go to the GPU straight from the view (a mapped file or an import)
+void Model::Upload(ModelResource& resource, const ModelMeshView& mesh, const std::string& directory) {
+    resource.indexCount = mesh.indexCount;
+    resource.indexType = mesh.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    resource.subMeshes.assign(mesh.subMeshes, mesh.subMeshes + size_t(mesh.subMeshCount) * mesh.lodCount);
+    resource.quantization = mesh.quantization;
+    glm::vec3 boundsSize(mesh.quantization.positionScale[0], mesh.quantization.positionScale[1], mesh.quantization.positionScale[2]);
+    resource.boundsCenter = glm::vec3(mesh.quantization.positionOffset[0], mesh.quantization.positionOffset[1], mesh.quantization.positionOffset[2])
+        + boundsSize * 0.5f;
+    resource.boundsRadius = glm::length(boundsSize) * 0.5f;
+    resource.gpuBytes = size_t(mesh.vertexCount) * sizeof(PackedVertex) + size_t(mesh.indexCount) * mesh.indexSize;
 
     // OpenGL buffer setup
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    glGenVertexArrays(1, &resource.VAO);
+    glGenBuffers(1, &resource.VBO);
+    glGenBuffers(1, &resource.EBO);
 
-    glBindVertexArray(VAO);
+    glBindVertexArray(resource.VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, resource.VBO);
+    glBufferData(GL_ARRAY_BUFFER, size_t(mesh.vertexCount) * sizeof(PackedVertex), mesh.vertices, GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resource.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_t(mesh.indexCount) * mesh.indexSize, mesh.indices, GL_STATIC_DRAW);
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // TexCoords attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // position, normal and uv
+    VertexLayout::Apply();
 
     glBindVertexArray(0);
 
-    std::cout << "In model constructor" << std::endl;
-
-    // Load texture from model material if available
-    textureID = 0;
-    if (scene->mNumMaterials > 0) {
-        std::cout << "In model constructor's if" << std::endl;
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-            aiString str;
-            material->GetTexture(aiTextureType_DIFFUSE, 0, &str);
-
-            std::string texName = str.C_Str();
-            std::string texPath = m_directory + texName;
+    // the texture of every material, the TextureCache loads a texture once however many materials and models use it;
+    // a material without one gets the white texture, so it doesn't show the texture of the batch drawn before it
+    std::shared_ptr<TextureResource> white = TextureCache::GetWhite();
+    resource.textures.push_back(white);
+    std::vector<unsigned int> materialTextures(mesh.materialTextures.size(), white->id);
+    for (size_t material = 0; material < mesh.materialTextures.size(); ++material) {
+        if (mesh.materialTextures[material].empty())
+            continue;
+        std::string texPath = directory + mesh.materialTextures[material];
+        std::shared_ptr<TextureResource> texture = TextureCache::Get(texPath, TextureSettings::Colormap());
+        materialTextures[material] = texture->id;
+        if (std::find(resource.textures.begin(), resource.textures.end(), texture) == resource.textures.end())
+            resource.textures.push_back(texture);
+    }
 
-            textureID = LoadTexture(texPath.c_str());
-            std::cout << texPath << std::endl;
+    // one batch per material and level
+    resource.lods.resize(mesh.lodCount);
+    for (uint32_t lod = 0; lod < mesh.lodCount; ++lod) {
+        ModelLod& level = resource.lods[lod];
+        for (uint32_t i = 0; i < mesh.subMeshCount; ++i) {
+            const ModelSubMesh& subMesh = resource.subMeshes[lod * mesh.subMeshCount + i];
+            level.triangles += subMesh.indexCount / 3;
+            if (level.batches.empty() || level.batches.back().material != subMesh.material) {
+                ModelBatch batch;
+                batch.material = subMesh.material;
+                batch.textureID = subMesh.material < materialTextures.size() ? materialTextures[subMesh.material] : white->id;
+                level.batches.push_back(batch);
+            }
+
+            // parts that follow each other in the index buffer become one range. In LOD 0 a material is always one
+            // range (the meshes are sorted by material), a mesh that couldn't be simplified any further draws the range
+            // of the level before it, which splits the material of a coarser level into several ranges
+            ModelBatch& batch = level.batches.back();
+            const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(subMesh.firstIndex) * mesh.indexSize);
+            if (!batch.counts.empty() && batch.firstIndices.back() + static_cast<unsigned int>(batch.counts.back()) == subMesh.firstIndex) {
+                batch.counts.back() += static_cast<int>(subMesh.indexCount);
+            }
+            else {
+                batch.counts.push_back(static_cast<int>(subMesh.indexCount));
+                batch.firstIndices.push_back(subMesh.firstIndex);
+                batch.offsets.push_back(offset);
+            }
         }
     }
-    
 }
 
-unsigned int Model::LoadTexture(const char* path) {
-    stbi_set_flip_vertically_on_load(true);
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-        else
-            format = GL_RGB;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, (format == GL_RGBA ? GL_SRGB_ALPHA : GL_SRGB), width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+// binds the texture of a batch, every batch has one (the white texture when its material has none)
+void Model::bindBatch(Shader& shader, const ModelBatch& batch) {
+    if (m_useTexture) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, batch.textureID);
+        shader.setInt("colormap", 0);
     }
-    else {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        stbi_image_free(data);
+}
+
+// the coarsest level whose size on screen (the diameter of the bounding sphere against the height of the screen)
+// is still above its threshold; nothing loaded or a single level is always LOD 0
+int Model::SelectLod(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) const {
+    const ModelResource& resource = *m_resource;
+    if (resource.lods.size() <= 1)
+        return 0;
+
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3 center = glm::vec3(view * model * glm::vec4(resource.boundsCenter, 1.0f));
+    float distance = glm::length(center);
+    float radius = resource.boundsRadius * scale;
+    if (distance <= radius)
+        return 0;
+
+    // projection[1][1] is cot(fov / 2), so this is the projected radius in NDC, where the screen is 2 high:
+    // radius against half the screen height is the diameter against the whole height (small sphere, near the center)
+    float screenSize = radius * projection[1][1] / distance;
+    int lod = 0;
+    while (lod + 1 < static_cast<int>(resource.lods.size()) && screenSize < LOD_SCREEN_SIZES[lod])
+        ++lod;
+    return lod;
+}
+
+int Model::GetLodCount() const {
+    return static_cast<int>(m_resource->lods.size());
+}
+
+unsigned int Model::GetTriangleCount(int lod) const {
+    return lod < GetLodCount() ? m_resource->lods[lod].triangles : 0;
+}
+
+// one multi draw per material
+void Model::Draw(Shader& shader, int lod) {
+    const ModelResource& resource = *m_resource;
+    if (resource.lods.empty())
+        return;
+    VertexLayout::SetUniforms(shader, resource.quantization);
+    glBindVertexArray(resource.VAO);
+    for (const ModelBatch& batch : resource.lods[std::min(lod, static_cast<int>(resource.lods.size()) - 1)].batches) {
+        bindBatch(shader, batch);
+        glMultiDrawElements(GL_TRIANGLES, batch.counts.data(), resource.indexType, batch.offsets.data(), static_cast<GLsizei>(batch.counts.size()));
     }
-    return textureID;
+    glBindVertexArray(0);
 }
 
-void Model::Draw(Shader& shader) {
-    if (m_useTexture && textureID) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        shader.setInt("colormap", 0);
+void Model::DrawInstanced(Shader& shader, unsigned int instanceBuffer, int count) {
+    ModelResource& resource = *m_resource;
+    if (count <= 0 || resource.lods.empty())
+        return;
+
+    VertexLayout::SetUniforms(shader, resource.quantization);
+    glBindVertexArray(resource.VAO);
+
+    // the VAO remembers the instance attributes, so they are only set up when the buffer changes
+    // (the VAO is shared, Cart and TrainSystem draw the same wagon with their own buffers)
+    if (resource.instanceBuffer != instanceBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (int i = 0; i < 4; ++i) {
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        resource.instanceBuffer = instanceBuffer;
+    }
+
+    // OpenGL 3.3 has no instanced multi draw, so every range of a batch is its own draw
+    for (const ModelBatch& batch : resource.lods[0].batches) {
+        bindBatch(shader, batch);
+        for (size_t i = 0; i < batch.counts.size(); ++i)
+            glDrawElementsInstanced(GL_TRIANGLES, batch.counts[i], resource.indexType, batch.offsets[i], count);
     }
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
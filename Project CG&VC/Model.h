@@ -6,23 +6,41 @@
 
 #include <string>
 #include <cstring>
+#include <memory>
 #include "Shader.h"
+#include "ModelCache.h"
 
+// A model file on the GPU, the file is imported once (ModelCache) and shared by all Models made from it.
+// All meshes of the file share one vertex and index buffer and are drawn with one multi draw per material,
+// in the level of detail that fits their size on screen.
 class Model {
 public:
 	Model(const std::string& path);
-	void Draw(Shader& shader);
-	unsigned int LoadTexture(const char* path);
+	// starts the import on a loader thread, the constructor then only waits for what is left
+	static void Prefetch(const std::string& path);
+	// lod is clamped to the levels the model has
+	void Draw(Shader& shader, int lod = 0);
+	// one draw for count copies, instanceBuffer holds a mat4 per instance (attributes 3 to 6)
+	void DrawInstanced(Shader& shader, unsigned int instanceBuffer, int count);
+
+	static const int MAX_LODS = ModelFile::MAX_LODS;
+	// the level for one instance from its size on screen
+	int SelectLod(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) const;
+	int GetLodCount() const;
+	unsigned int GetTriangleCount(int lod) const;
+
+	// takes the import from the AssetLoader and uploads it; only called by the ModelCache
+	static std::shared_ptr<ModelResource> Import(const std::string& path);
 
 private:
-	std::string m_directory;
+	static void Upload(ModelResource& resource, const ModelMeshView& mesh, const std::string& directory);
 
-	bool m_useTexture = true;
+	static const float LOD_SCREEN_SIZES[MAX_LODS];
 
-	unsigned int VAO, VBO, EBO;
-	unsigned int indexCount;
-	unsigned int textureID;
+	bool m_useTexture = true;
 
+	void bindBatch(Shader& shader, const ModelBatch& batch);
 
+	std::shared_ptr<ModelResource> m_resource;
 };
 
@@ -0,0 +1,54 @@
+#include "ModelCache.h"
+#include "Model.h"
+
+#include <glad/glad.h>
+
+ModelResource::~ModelResource() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+std::unordered_map<std::string, std::weak_ptr<ModelResource>>& ModelCache::entries() {
+    static std::unordered_map<std::string, std::weak_ptr<ModelResource>> map;
+    return map;
+}
+
+ModelCacheStats& ModelCache::counters() {
+    static ModelCacheStats stats;
+    return stats;
+}
+
+std::shared_ptr<ModelResource> ModelCache::Get(const std::string& path) {
+    // "models/a.fbx" and "models\a.fbx" are the same file
+    std::string key = path;
+    for (char& c : key) {
+        if (c == '/')
+            c = '\\';
+    }
+
+    std::weak_ptr<ModelResource>& entry = entries()[key];
+    std::shared_ptr<ModelResource> resource = entry.lock();
+    if (resource) {
+        ++counters().hits;
+        return resource;
+    }
+
+    resource = Model::Import(path);
+    entry = resource;
+    ++counters().imports;
+    return resource;
+}
+
+ModelCacheStats ModelCache::GetStats() {
+    ModelCacheStats stats = counters();
+    for (const auto& entry : entries()) {
+        std::shared_ptr<ModelResource> resource = entry.second.lock();
+        if (!resource)
+            continue;
+        ++stats.uniqueModels;
+        stats.references += resource.use_count() - 1;	// without the lock above
+        stats.gpuBytes += resource->gpuBytes;
+    }
+    return stats;
+}
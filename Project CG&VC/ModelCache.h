@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ModelFile.h"
+#include "TextureCache.h"
+
+// The meshes with the same material, drawn with one glMultiDrawElements
+struct ModelBatch {
+	unsigned int material = 0;
+	unsigned int textureID = 0;
+	std::vector<int> counts;				// GLsizei
+	std::vector<unsigned int> firstIndices;
+	std::vector<const void*> offsets;		// byte offsets in the index buffer
+};
+
+// The batches of one level of detail
+struct ModelLod {
+	std::vector<ModelBatch> batches;
+	unsigned int triangles = 0;
+};
+
+// GPU data of one imported model file, shared by every Model that was made from that file
+struct ModelResource {
+	std::string path;
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+	unsigned int indexCount = 0;
+	unsigned int indexType = 0;			// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	VertexQuantization quantization;	// decode uniforms of the packed vertices
+	std::vector<ModelSubMesh> subMeshes;	// the draw table, the sub meshes of every level one after the other
+	std::vector<ModelLod> lods;			// LOD 0 is the full mesh
+	glm::vec3 boundsCenter = glm::vec3(0.0f);	// sphere around the mesh, for picking the level
+	float boundsRadius = 0.0f;
+	std::vector<std::shared_ptr<TextureResource>> textures;	// keeps the textures of the batches alive
+	unsigned int instanceBuffer = 0;	// instance buffer that is attached to the (shared) VAO
+	size_t gpuBytes = 0;				// vertices and indices, the textures are counted by the TextureCache
+
+	ModelResource() = default;
+	~ModelResource();
+	ModelResource(const ModelResource&) = delete;
+	ModelResource& operator=(const ModelResource&) = delete;
+};
+
+struct ModelCacheStats {
+	size_t uniqueModels = 0;	// files that are loaded right now
+	size_t references = 0;		// Models that use them
+	size_t imports = 0;			// Assimp imports since the start
+	size_t hits = 0;			// requests that reused a loaded file
+	size_t gpuBytes = 0;
+};
+
+/*
+* Imports every model file once and hands out shared GPU resources
+* containts:
+*		- a map from path to a weak reference, the resource is freed when the last Model using it is gone
+*		- statistics, so the cost of the scene can be compared with the number of unique assets
+*/
+class ModelCache {
+public:
+	static std::shared_ptr<ModelResource> Get(const std::string& path);
+	static ModelCacheStats GetStats();
+
+private:
+	static std::unordered_map<std::string, std::weak_ptr<ModelResource>>& entries();
+	static ModelCacheStats& counters();
+};
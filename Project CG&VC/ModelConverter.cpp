@@ -0,0 +1,86 @@
+// Offline converter: bakes every FBX/OBJ into the .meshb that Model loads at startup
+//
+// usage: ModelConverter [files or directories...]   (default: .\models)
+// A baked file that still belongs to its source is skipped, --force bakes everything again.
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "ModelFile.h"
+
+namespace fs = std::filesystem;
+
+static bool isModel(const fs::path& path) {
+	std::string extension = path.extension().string();
+	for (char& c : extension)
+		c = static_cast<char>(tolower(c));
+	return extension == ".fbx" || extension == ".obj";
+}
+
+// returns false when the model can't be imported or written
+static bool convert(const std::string& path, bool force) {
+	std::string bakedPath = ModelFile::BakedPath(path);
+	uint64_t sourceHash = ModelFile::HashSource(path);
+
+	if (!force) {
+		MappedFile baked;
+		ModelMeshView view;
+		if (ModelFile::Map(baked, bakedPath, sourceHash, view)) {
+			std::cout << "up to date  " << path << std::endl;
+			return true;
+		}
+	}
+
+	ModelMeshData data;
+	if (!ModelFile::Import(path, data))
+		return false;
+
+	try {
+		ModelFile::Save(bakedPath, data, sourceHash);
+	}
+	catch (const std::exception& e) {
+		std::cout << "ERROR::CONVERTER::" << e.what() << std::endl;
+		return false;
+	}
+	ModelMeshView view = ModelFile::View(data);
+	std::cout << "baked       " << path << " (" << view.subMeshCount << " meshes, " << view.vertexCount << " vertices, triangles per LOD";
+	for (uint32_t lod = 0; lod < view.lodCount; ++lod)
+		std::cout << (lod == 0 ? " " : "/") << ModelFile::TriangleCount(view, lod);
+	std::cout << ", " << (view.indexSize == 2 ? 16 : 32) << " bit indices, ACMR " << data.sourceACMR << " -> " << data.optimizedACMR << ")" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	bool force = false;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--force")
+			force = true;
+		else
+			inputs.push_back(argument);
+	}
+	if (inputs.empty())
+		inputs.push_back(".\\models");
+
+	int failed = 0;
+	for (const std::string& input : inputs) {
+		std::error_code error;
+		if (fs::is_directory(input, error)) {
+			for (const auto& entry : fs::recursive_directory_iterator(input, error)) {
+				if (entry.is_regular_file() && isModel(entry.path()) && !convert(entry.path().string(), force))
+					++failed;
+			}
+		}
+		else if (!convert(input, force)) {
+			++failed;
+		}
+	}
+
+	if (failed > 0)
+		std::cout << failed << " model(s) failed" << std::endl;
+	return failed > 0 ? 1 : 0;
+}
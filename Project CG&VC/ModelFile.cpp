@@ -0,0 +1,338 @@
+#include "ModelFile.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "TrackFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <stdexcept>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <glm/glm.hpp>
+
+// bump when the import settings or the layout change, older baked files are then made again
+static const uint32_t MODEL_FILE_VERSION = 6;
+static const uint32_t MODEL_VERTEX_FLOATS = 8;
+
+// the largest error a level may add, relative to the size of the model
+static const float LOD_ERRORS[ModelFile::MAX_LODS] = { 0.0f, 0.01f, 0.02f, 0.05f };
+
+static_assert(sizeof(ModelFileHeader) == 80, "ModelFileHeader is written as is");
+static_assert(sizeof(ModelSubMesh) == 12, "ModelSubMesh is written as is");
+
+bool ModelFile::Import(const std::string& path, ModelMeshData& data) {
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path,
+        aiProcess_Triangulate |
+        aiProcess_GenSmoothNormals |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_PreTransformVertices);
+
+    if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
+        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    // all meshes go into one vertex and index buffer, ordered by material so the parts
+    // that share a material end up next to each other in the index buffer
+    std::vector<unsigned int> meshOrder(scene->mNumMeshes);
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+        meshOrder[i] = i;
+    std::stable_sort(meshOrder.begin(), meshOrder.end(), [scene](unsigned int a, unsigned int b) {
+        return scene->mMeshes[a]->mMaterialIndex < scene->mMeshes[b]->mMaterialIndex;
+    });
+
+    data = ModelMeshData();
+
+    // every mesh on its own first: optimised for the GPU, then simplified into the levels of detail
+    struct ImportedMesh {
+        uint32_t material;
+        std::vector<float> vertices;
+        std::vector<std::vector<uint32_t>> lods;
+    };
+    std::vector<ImportedMesh> meshes;
+    double sourceMisses = 0.0, optimizedMisses = 0.0;
+    size_t triangles = 0;
+    glm::vec3 minPosition(std::numeric_limits<float>::max()), maxPosition(-std::numeric_limits<float>::max());
+    for (unsigned int meshIndex : meshOrder) {
+        aiMesh* mesh = scene->mMeshes[meshIndex];
+        meshes.push_back(ImportedMesh());
+        ImportedMesh& imported = meshes.back();
+        imported.material = mesh->mMaterialIndex;
+        std::vector<float>& vertices = imported.vertices;
+        vertices.reserve(size_t(mesh->mNumVertices) * MODEL_VERTEX_FLOATS);
+
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+            // Position
+            vertices.push_back(mesh->mVertices[i].x);
+            vertices.push_back(mesh->mVertices[i].y);
+            vertices.push_back(mesh->mVertices[i].z);
+            minPosition = glm::min(minPosition, glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z));
+            maxPosition = glm::max(maxPosition, glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z));
+            // Normal
+            if (mesh->HasNormals()) {
+                vertices.push_back(mesh->mNormals[i].x);
+                vertices.push_back(mesh->mNormals[i].y);
+                vertices.push_back(mesh->mNormals[i].z);
+            }
+            else {
+                vertices.push_back(0.0f);
+                vertices.push_back(0.0f);
+                vertices.push_back(0.0f);
+            }
+            // TexCoords
+            if (mesh->HasTextureCoords(0)) {
+                vertices.push_back(mesh->mTextureCoords[0][i].x);
+                vertices.push_back(mesh->mTextureCoords[0][i].y);
+            }
+            else {
+                vertices.push_back(0.0f);
+                vertices.push_back(0.0f);
+            }
+        }
+
+        imported.lods.resize(1);
+        std::vector<uint32_t>& indices = imported.lods[0];
+        indices.reserve(size_t(mesh->mNumFaces) * 3);
+        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+            // points and lines are left as they are by aiProcess_Triangulate, they can't be drawn as triangles
+            const aiFace& face = mesh->mFaces[i];
+            if (face.mNumIndices != 3)
+                continue;
+            for (unsigned int j = 0; j < face.mNumIndices; ++j)
+                indices.push_back(face.mIndices[j]);
+        }
+
+        // triangles for the vertex cache, then outward facing clusters first, then vertices in the order they are used
+        float sourceACMR = MeshOptimizer::ComputeACMR(indices.data(), indices.size());
+        sourceMisses += sourceACMR * (indices.size() / 3);
+        std::vector<uint32_t> sourceOrder = indices;
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), mesh->mNumVertices);
+
+        // the clusters break up the cache order at their borders, the overdraw order is only kept when that costs nothing
+        std::vector<uint32_t> cacheOrder = indices;
+        float cacheACMR = MeshOptimizer::ComputeACMR(cacheOrder.data(), cacheOrder.size());
+        MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), MODEL_VERTEX_FLOATS);
+        if (MeshOptimizer::ComputeACMR(indices.data(), indices.size()) > cacheACMR)
+            indices = cacheOrder;
+        // a file that already comes in a better order keeps it
+        if (MeshOptimizer::ComputeACMR(indices.data(), indices.size()) > sourceACMR)
+            indices = sourceOrder;
+
+        MeshOptimizer::OptimizeVertexFetch(vertices, MODEL_VERTEX_FLOATS, indices.data(), indices.size());
+        optimizedMisses += MeshOptimizer::ComputeACMR(indices.data(), indices.size()) * (indices.size() / 3);
+        triangles += indices.size() / 3;
+    }
+
+    if (triangles > 0) {
+        data.sourceACMR = static_cast<float>(sourceMisses / triangles);
+        data.optimizedACMR = static_cast<float>(optimizedMisses / triangles);
+    }
+
+    // every level halves the triangles of the one before, as long as the surface stays within the allowed
+    // error (relative to the whole model, so all its meshes lose detail alike); a level that hardly
+    // removes anything draws the one before, the next level tries again with its larger error
+    float extent = triangles > 0 ? glm::length(maxPosition - minPosition) : 0.0f;
+    data.lodCount = 1;
+    for (uint32_t lod = 1; lod < MAX_LODS; ++lod) {
+        size_t previousTriangles = 0, lodTriangles = 0;
+        std::vector<std::vector<uint32_t>> simplified(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const std::vector<uint32_t>& previous = meshes[i].lods.back();
+            simplified[i] = MeshOptimizer::Simplify(previous.data(), previous.size(), meshes[i].vertices.data(),
+                meshes[i].vertices.size() / MODEL_VERTEX_FLOATS, MODEL_VERTEX_FLOATS, previous.size() / 2, LOD_ERRORS[lod], extent);
+            if (simplified[i].size() < previous.size())
+                MeshOptimizer::OptimizeVertexCache(simplified[i].data(), simplified[i].size(), meshes[i].vertices.size() / MODEL_VERTEX_FLOATS);
+            else
+                simplified[i] = previous;
+            previousTriangles += previous.size() / 3;
+            lodTriangles += simplified[i].size() / 3;
+        }
+        for (size_t i = 0; i < meshes.size(); ++i)
+            meshes[i].lods.push_back(lodTriangles > previousTriangles * 9 / 10 ? meshes[i].lods.back() : std::move(simplified[i]));
+        ++data.lodCount;
+    }
+    // levels at the end that only repeat the one before are dropped
+    while (data.lodCount > 1 && std::all_of(meshes.begin(), meshes.end(), [&](const ImportedMesh& mesh) {
+        return mesh.lods[data.lodCount - 1] == mesh.lods[data.lodCount - 2];
+    })) {
+        for (ImportedMesh& mesh : meshes)
+            mesh.lods.pop_back();
+        --data.lodCount;
+    }
+    if (data.lodCount == 1)
+        std::cout << "WARNING::MODELFILE::" << path << " has no level of detail, all " << triangles << " triangles are drawn at every distance" << std::endl;
+
+    // all meshes go into one vertex and one index buffer; the index buffer holds LOD 0 of every mesh, then LOD 1
+    // and so on, so the meshes of a material stay next to each other in every level
+    data.subMeshes.resize(meshes.size() * data.lodCount);
+    std::vector<uint32_t> baseVertices(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        baseVertices[i] = static_cast<uint32_t>(data.vertices.size() / MODEL_VERTEX_FLOATS);
+        data.vertices.insert(data.vertices.end(), meshes[i].vertices.begin(), meshes[i].vertices.end());
+        for (uint32_t lod = 0; lod < data.lodCount; ++lod)
+            data.subMeshes[lod * meshes.size() + i].material = meshes[i].material;
+    }
+    for (uint32_t lod = 0; lod < data.lodCount; ++lod) {
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            // the indices are rebased on the shared buffer, so no base vertex is needed when drawing
+            ModelSubMesh& subMesh = data.subMeshes[lod * meshes.size() + i];
+            if (lod > 0 && meshes[i].lods[lod] == meshes[i].lods[lod - 1]) {
+                // a mesh that couldn't be simplified further draws the range of the level before
+                subMesh = data.subMeshes[(lod - 1) * meshes.size() + i];
+                continue;
+            }
+            subMesh.firstIndex = static_cast<uint32_t>(data.indices.size());
+            for (uint32_t index : meshes[i].lods[lod])
+                data.indices.push_back(baseVertices[i] + index);
+            subMesh.indexCount = static_cast<uint32_t>(data.indices.size()) - subMesh.firstIndex;
+        }
+    }
+
+    data.quantization = VertexPacking::Pack(data.vertices.data(), data.vertices.size() / MODEL_VERTEX_FLOATS, MODEL_VERTEX_FLOATS,
+        0, 3, 6, data.packedVertices);
+
+    // half the index memory and bandwidth when every index fits
+    if (data.vertices.size() / MODEL_VERTEX_FLOATS <= 0xffff)
+        data.shortIndices.assign(data.indices.begin(), data.indices.end());
+
+    // the diffuse texture of every material
+    data.materialTextures.resize(scene->mNumMaterials);
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i) {
+        aiMaterial* material = scene->mMaterials[i];
+        if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+            aiString str;
+            material->GetTexture(aiTextureType_DIFFUSE, 0, &str);
+            data.materialTextures[i] = str.C_Str();
+        }
+    }
+    return true;
+}
+
+void ModelFile::Save(const std::string& path, const ModelMeshData& data, uint64_t sourceHash) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("ModelFile: can't write " + path);
+
+    ModelFileHeader header = { { 'M', 'D', 'L', 'B' }, MODEL_FILE_VERSION, sourceHash,
+        static_cast<uint32_t>(data.subMeshes.size() / data.lodCount), static_cast<uint32_t>(data.packedVertices.size()),
+        static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(data.materialTextures.size()),
+        data.shortIndices.empty() ? 4u : 2u, data.lodCount, data.quantization };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(data.subMeshes.data()), data.subMeshes.size() * sizeof(ModelSubMesh));
+    file.write(reinterpret_cast<const char*>(data.packedVertices.data()), data.packedVertices.size() * sizeof(PackedVertex));
+    if (data.shortIndices.empty())
+        file.write(reinterpret_cast<const char*>(data.indices.data()), data.indices.size() * sizeof(uint32_t));
+    else
+        file.write(reinterpret_cast<const char*>(data.shortIndices.data()), data.shortIndices.size() * sizeof(uint16_t));
+    for (const std::string& texture : data.materialTextures) {
+        uint32_t length = static_cast<uint32_t>(texture.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(texture.data(), length);
+    }
+}
+
+bool ModelFile::Map(MappedFile& file, const std::string& path, uint64_t sourceHash, ModelMeshView& view) {
+    if (!file.Open(path))
+        return false;
+
+    ModelFileHeader header;
+    if (file.GetSize() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (std::memcmp(header.magic, "MDLB", 4) != 0 || header.version != MODEL_FILE_VERSION)
+        return false;
+    if (sourceHash != 0 && header.sourceHash != sourceHash)
+        return false;
+    if (header.indexSize != 2 && header.indexSize != 4)
+        return false;
+    if (header.lodCount < 1 || header.lodCount > MAX_LODS)
+        return false;
+
+    size_t offset = sizeof(header);
+    size_t streams = size_t(header.subMeshCount) * header.lodCount * sizeof(ModelSubMesh) + size_t(header.vertexCount) * sizeof(PackedVertex)
+        + size_t(header.indexCount) * header.indexSize;
+    if (file.GetSize() < offset + streams)
+        return false;
+
+    // the streams before the indices are multiples of 4 bytes, so the pointers stay aligned
+    const unsigned char* data = file.GetData();
+    view.subMeshes = reinterpret_cast<const ModelSubMesh*>(data + offset);
+    view.subMeshCount = header.subMeshCount;
+    view.lodCount = header.lodCount;
+    offset += size_t(header.subMeshCount) * header.lodCount * sizeof(ModelSubMesh);
+    view.vertices = reinterpret_cast<const PackedVertex*>(data + offset);
+    view.vertexCount = header.vertexCount;
+    view.quantization = header.quantization;
+    offset += size_t(header.vertexCount) * sizeof(PackedVertex);
+    view.indices = data + offset;
+    view.indexCount = header.indexCount;
+    view.indexSize = header.indexSize;
+    offset += size_t(header.indexCount) * header.indexSize;
+
+    // a broken file would make the GPU read outside the buffers: every range has to lie in the index
+    // buffer and every index has to point at a vertex
+    for (size_t i = 0; i < size_t(header.subMeshCount) * header.lodCount; ++i) {
+        if (uint64_t(view.subMeshes[i].firstIndex) + view.subMeshes[i].indexCount > header.indexCount)
+            return false;
+    }
+    for (uint32_t i = 0; i < header.indexCount; ++i) {
+        uint32_t index = header.indexSize == 2 ? static_cast<const uint16_t*>(view.indices)[i] : static_cast<const uint32_t*>(view.indices)[i];
+        if (index >= header.vertexCount)
+            return false;
+    }
+
+    view.materialTextures.assign(header.materialCount, std::string());
+    for (uint32_t i = 0; i < header.materialCount; ++i) {
+        uint32_t length;
+        if (file.GetSize() < offset + sizeof(length))
+            return false;
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (file.GetSize() < offset + length)
+            return false;
+        view.materialTextures[i].assign(reinterpret_cast<const char*>(data + offset), length);
+        offset += length;
+    }
+    return true;
+}
+
+uint64_t ModelFile::HashSource(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path))
+        return 0;
+    return TrackFile::Hash(file.GetData(), file.GetSize());
+}
+
+ModelMeshView ModelFile::View(const ModelMeshData& data) {
+    ModelMeshView view;
+    view.vertices = data.packedVertices.data();
+    view.vertexCount = static_cast<uint32_t>(data.packedVertices.size());
+    view.quantization = data.quantization;
+    view.indexCount = static_cast<uint32_t>(data.indices.size());
+    if (data.shortIndices.empty()) {
+        view.indices = data.indices.data();
+        view.indexSize = sizeof(uint32_t);
+    }
+    else {
+        view.indices = data.shortIndices.data();
+        view.indexSize = sizeof(uint16_t);
+    }
+    view.subMeshes = data.subMeshes.data();
+    view.subMeshCount = static_cast<uint32_t>(data.subMeshes.size() / data.lodCount);
+    view.lodCount = data.lodCount;
+    view.materialTextures = data.materialTextures;
+    return view;
+}
+
+uint32_t ModelFile::TriangleCount(const ModelMeshView& view, uint32_t lod) {
+    uint32_t triangles = 0;
+    for (uint32_t i = 0; i < view.subMeshCount; ++i)
+        triangles += view.subMeshes[lod * view.subMeshCount + i].indexCount / 3;
+    return triangles;
+}
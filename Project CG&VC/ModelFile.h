@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "VertexPacking.h"
+
+class MappedFile;
+
+// One mesh of a model file, a range of the shared index buffer (the indices are already rebased)
+struct ModelSubMesh {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	uint32_t material = 0;
+};
+
+// Header of a baked model (.meshb), followed by the sub meshes of every LOD, the packed vertices (PackedVertex),
+// the indices (16 or 32 bit) and per material the length and the characters of its texture path
+struct ModelFileHeader {
+	char magic[4];			// "MDLB"
+	uint32_t version;
+	uint64_t sourceHash;	// FNV-1a of the FBX/OBJ it was made from
+	uint32_t subMeshCount;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t materialCount;
+	uint32_t indexSize;		// 2 or 4 bytes
+	uint32_t lodCount;		// subMeshCount sub meshes per level
+	VertexQuantization quantization;
+};
+
+// A model on the CPU, all meshes packed together and sorted by material; subMeshes holds the
+// sub meshes of LOD 0, then the ones of LOD 1 and so on, all levels share the vertices
+struct ModelMeshData {
+	std::vector<float> vertices;		// position, normal, uv: 8 floats
+	std::vector<PackedVertex> packedVertices;	// what is saved and uploaded
+	VertexQuantization quantization;
+	std::vector<uint32_t> indices;
+	std::vector<uint16_t> shortIndices;		// the same indices as 16 bit, when there are fewer than 65536 vertices
+	std::vector<ModelSubMesh> subMeshes;
+	uint32_t lodCount = 1;
+	std::vector<std::string> materialTextures;	// diffuse texture per material, relative to the model, empty if none
+	float sourceACMR = 0.0f;		// simulated cache misses per triangle in the order of the source file
+	float optimizedACMR = 0.0f;		// and after the import reordered it
+};
+
+// The same, but pointing into a mapped .meshb (or into a ModelMeshData)
+struct ModelMeshView {
+	const PackedVertex* vertices = nullptr;
+	uint32_t vertexCount = 0;
+	VertexQuantization quantization;
+	const void* indices = nullptr;
+	uint32_t indexCount = 0;
+	uint32_t indexSize = 4;		// 2: uint16_t, 4: uint32_t
+	const ModelSubMesh* subMeshes = nullptr;	// subMeshCount * lodCount
+	uint32_t subMeshCount = 0;		// per level
+	uint32_t lodCount = 1;
+	std::vector<std::string> materialTextures;
+};
+
+/*
+* Imports model files with Assimp and bakes them into a binary blob that loads without parsing
+* containts:
+*		- the Assimp import (all meshes in one vertex and index buffer, one draw table), reordered by the
+*		  MeshOptimizer for the vertex cache and with 16 bit indices where they fit
+*		- packing of the vertices into the VertexPacking format, done once at bake time
+*		- up to MAX_LODS levels of detail, simplified from the full mesh and sharing its vertices
+*		- the .meshb format: written next to the source, mapped and uploaded as is when loading
+*		- the source hash, so a baked model is only used while its FBX/OBJ hasn't changed
+*/
+class ModelFile {
+public:
+	static const uint32_t MAX_LODS = 4;
+
+	static std::string BakedPath(const std::string& sourcePath) { return sourcePath + ".meshb"; }
+
+	// false (and an ERROR::ASSIMP message) when the file can't be imported
+	static bool Import(const std::string& path, ModelMeshData& data);
+
+	// throws std::runtime_error when the file can't be written
+	static void Save(const std::string& path, const ModelMeshData& data, uint64_t sourceHash);
+
+	// false when the baked file is missing, broken or made from another source; a sourceHash
+	// of 0 (no source file next to it) accepts any baked file
+	static bool Map(MappedFile& file, const std::string& path, uint64_t sourceHash, ModelMeshView& view);
+
+	// 0 when the file doesn't exist
+	static uint64_t HashSource(const std::string& path);
+
+	static ModelMeshView View(const ModelMeshData& data);
+
+	static uint32_t TriangleCount(const ModelMeshView& view, uint32_t lod);
+};
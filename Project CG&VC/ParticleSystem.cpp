@@ -1,5 +1,4 @@
 #include "ParticleSystem.h"
-#include "stb_image.h"
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <random>
@@ -37,7 +36,8 @@ ParticleSystem::ParticleSystem(unsigned int maxParticles, const char* texturePat
 
     glBindVertexArray(0);
 
-    m_texture = loadTexture(texturePath);
+    // all emitters share the texture
+    m_texture = TextureCache::Get(texturePath, TextureSettings::Sprite());
 
     // Init all particles as dead
     for (auto& p : m_particles) p.life = -1.0f;
@@ -46,7 +46,6 @@ ParticleSystem::ParticleSystem(unsigned int maxParticles, const char* texturePat
 ParticleSystem::~ParticleSystem() {
     glDeleteVertexArrays(1, &m_VAO);
     glDeleteBuffers(1, &m_VBO);
-    glDeleteTextures(1, &m_texture);
 }
 
 void ParticleSystem::Update(float dt, const glm::vec3& emitterPos) {
@@ -71,7 +70,7 @@ void ParticleSystem::Render(const glm::mat4& projection, const glm::mat4& view)
     m_shader.setMat4("projection", projection);
     m_shader.setMat4("view", view);
     glBindVertexArray(m_VAO);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture->id);
 
     for (const auto& p : m_particles) {
         if (p.life > 0.0f) {
@@ -96,19 +95,6 @@ void ParticleSystem::respawnParticle(Particle& particle, const glm::vec3& emitte
     particle.scale = 2.0f + dist(rng) * 1.0f;
 }
 
-unsigned int ParticleSystem::loadTexture(const char* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 4);
-    if (data) {
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-    }
-    return textureID;
+void ParticleSystem::Prefetch(const char* texturePath) {
+    TextureCache::Prefetch(texturePath, TextureSettings::Sprite());
 }
@@ -1,7 +1,9 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include <memory>
 #include "Shader.h"
+#include "TextureCache.h"
 
 struct Particle {
     glm::vec3 position;
@@ -16,6 +18,7 @@ class ParticleSystem {
 public:
     ParticleSystem(unsigned int maxParticles, const char* texturePath);
     ~ParticleSystem();
+    static void Prefetch(const char* texturePath);
 
     void Update(float dt, const glm::vec3& emitterPos);
     void Render(const glm::mat4& projection, const glm::mat4& view);
@@ -28,11 +31,10 @@ private:
 
     unsigned int m_maxParticles;
     unsigned int m_VAO, m_VBO;
-    unsigned int m_texture;
+    std::shared_ptr<TextureResource> m_texture;
 
     Shader m_shader;
     bool m_active;
 
     void respawnParticle(Particle& particle, const glm::vec3& emitterPos);
-    unsigned int loadTexture(const char* path);
 };
@@ -0,0 +1,55 @@
+#include "RideRecording.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const uint32_t RIDE_RECORDING_VERSION = 2;
+
+RideRecording RideRecording::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("RideRecording: can't open " + path);
+
+    RideRecordingHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        throw std::runtime_error("RideRecording: " + path + " is too small");
+    if (std::memcmp(header.magic, "RIDE", 4) != 0 || header.version != RIDE_RECORDING_VERSION || header.frameSize != sizeof(RecordedFrame))
+        throw std::runtime_error("RideRecording: " + path + " is not a version " + std::to_string(RIDE_RECORDING_VERSION) + " recording");
+
+    RideRecording recording;
+    recording.frames.resize(header.frameCount);
+    if (!file.read(reinterpret_cast<char*>(recording.frames.data()), header.frameCount * sizeof(RecordedFrame)))
+        throw std::runtime_error("RideRecording: " + path + " is truncated");
+    return recording;
+}
+
+void RideRecording::Save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("RideRecording: can't write " + path);
+
+    RideRecordingHeader header = { { 'R', 'I', 'D', 'E' }, RIDE_RECORDING_VERSION, static_cast<uint32_t>(frames.size()), sizeof(RecordedFrame) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(RecordedFrame));
+}
+
+FrameTimePercentiles RideRecording::ComputePercentiles(std::vector<float> frameTimes) {
+    FrameTimePercentiles result;
+    result.frames = frameTimes.size();
+    if (frameTimes.empty())
+        return result;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&](float p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * frameTimes.size()));
+        return frameTimes[std::min(std::max(rank, size_t(1)), frameTimes.size()) - 1];
+    };
+    result.p50 = percentile(0.50f);
+    result.p95 = percentile(0.95f);
+    result.p99 = percentile(0.99f);
+    result.max = frameTimes.back();
+    return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CartPhysics.h"
+
+// Header of a recorded ride (.ride), followed by frameCount frames
+struct RideRecordingHeader {
+	char magic[4];			// "RIDE"
+	uint32_t version;
+	uint32_t frameCount;
+	uint32_t frameSize;		// sizeof(RecordedFrame), a changed layout isn't read as garbage
+};
+
+// One frame of a ride, written as is. The replay runs at its own forced timestep, so the wall clock
+// frame time isn't stored, and the camera pose already holds what the movement keys did.
+struct RecordedFrame {
+	float position[3];		// camera pose
+	float yaw;
+	float pitch;
+	float zoom;
+	uint8_t cameraOption;
+	uint8_t fireActive;
+	uint8_t kernel;			// PostProcessKernel::Type
+	uint8_t reserved;
+	uint32_t trainCount;
+	CartSnapshot cart;		// fixed timestep state of the cart after its update
+};
+
+// p50/p95/p99 of the frame times of a replay
+struct FrameTimePercentiles {
+	size_t frames = 0;
+	float p50 = 0.0f;
+	float p95 = 0.0f;
+	float p99 = 0.0f;
+	float max = 0.0f;
+};
+
+/*
+* A recorded camera and cart ride, used for benchmarks that can be compared between builds
+* containts:
+*		- the camera pose, toggles and the cart state of every frame
+*		- a compact binary file, read and written in one go
+*		- frame time percentiles of a replay
+*/
+class RideRecording {
+public:
+	std::vector<RecordedFrame> frames;
+
+	// throws std::runtime_error when the file can't be read or written
+	static RideRecording Load(const std::string& path);
+	void Save(const std::string& path) const;
+
+	// nearest rank percentiles, the frame times are in milliseconds
+	static FrameTimePercentiles ComputePercentiles(std::vector<float> frameTimes);
+};
@@ -1,105 +1,205 @@
 #include "RollerCoaster.h"
 #include "BezierCurve.h"
+#include "Frustum.h"
+#include "MappedFile.h"
+#include "TrackFile.h"
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+// bump when the layout of the baked track mesh changes
+static const uint32_t TRACK_MESH_VERSION = 2;
+
 // Constructor
-RollerCoaster::RollerCoaster(std::vector<std::vector<glm::vec3>> bezierSegments, int cylinderSegments) 
-    : m_cylinderSegments(cylinderSegments), m_shader(".\\BezierShader.vert", ".\\BezierShader.frag") {
+RollerCoaster::RollerCoaster(std::vector<std::vector<glm::vec3>> bezierSegments, int cylinderSegments, const std::string& meshCachePath) 
+    : m_track(bezierSegments), m_cylinderSegments(cylinderSegments), m_shader(".\\BezierShader.vert", ".\\BezierShader.frag") {
 
-    for (const auto& segment : bezierSegments) {
+    for (const auto& segment : m_track.GetSegments()) {
         m_curves.emplace_back(segment);
     }
 
-    // Genereer cilinders voor de Bzier-curves
-    GenerateCylinders();
-    GeneratePillars(10.0f); // Elke 10 eenheden een pilaar
+    // sample the track once, all geometry below is built from these tables
+    m_sampler.Build(m_curves);
+    m_railParameters.resize(m_curves.size());
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // Color attribute
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // a baked mesh skips all geometry generation
+    if (!meshCachePath.empty() && LoadMeshCache(meshCachePath))
+        return;
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    BuildMesh(vertices, indices);
+    uploadBuffers(vertices.data(), vertices.size() / 6, indices.data(), indices.size());
+
+    if (!meshCachePath.empty())
+        SaveMeshCache(meshCachePath, vertices, indices);
 }
 
 // Destructor
 RollerCoaster::~RollerCoaster() {
-    // Verwijder alle VAOs
-    for (unsigned int vao : m_cylinderVAOs) {
-        glDeleteVertexArrays(1, &vao);
-    }
+    CleanUp();
 }
 
-// Hulpmethode om cilinders te genereren
-void RollerCoaster::GenerateCylinders() {
-    m_cylinderVAOs.clear();
-
-    for (auto& curve : m_curves) {
-        std::vector<glm::vec3> curvePoints = curve.GeneratePoints(100);
-        for (size_t i = 0; i < curvePoints.size() - 1; ++i) {
-            glm::vec3 start = curvePoints[i];
-            glm::vec3 end = curvePoints[i + 1];
-            glm::vec3 direction = glm::normalize(end - start);
-
-            // Bepaal de lokale up en right vector
-            glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
-            if (glm::length(glm::cross(direction, up)) < 0.01f)
-                up = glm::vec3(1.0f, 0.0f, 0.0f);
-            glm::vec3 right = glm::normalize(glm::cross(up, direction));
-            up = glm::normalize(glm::cross(direction, right));
-
-            // Offset voor linker- en rechterrail
-            float halfWidth = m_trackWidth * 0.5f;
-            glm::vec3 leftOffset = -right * halfWidth;
-            glm::vec3 rightOffset = right * halfWidth;
-
-            // Genereer VAO voor linkerrail
-            unsigned int leftVAO = createCylinderVAO(
-                start + leftOffset,
-                end + leftOffset,
-                m_cylinderRadius,
-                m_cylinderSegments
-            );
-            m_cylinderVAOs.push_back(leftVAO);
-
-            // Genereer VAO voor rechterrail
-            unsigned int rightVAO = createCylinderVAO(
-                start + rightOffset,
-                end + rightOffset,
-                m_cylinderRadius,
-                m_cylinderSegments
-            );
-            m_cylinderVAOs.push_back(rightVAO);
-
-            // Genereer VAO voor dwarsligger (crossbar)
-            unsigned int crossbarVAO = createCrossbarVAO(
-                start + leftOffset,
-                start + rightOffset,
-                m_crossbarThickness // e.g. 0.05f
-            );
-            m_cylinderVAOs.push_back(crossbarVAO);
+// Moves a control point of the track. The track keeps its joints smooth, so at most the segment
+// before and after the point change; only those are sampled, meshed and uploaded again.
+void RollerCoaster::MoveControlPoint(int segment, int index, const glm::vec3& position) {
+    double start = glfwGetTime();
+
+    std::vector<int> dirty = m_track.MoveControlPoint(segment, index, position);
+    for (int curve : dirty)
+        m_curves[curve] = BezierCurve(m_track.GetSegments()[curve]);
+    m_sampler.Rebuild(m_curves, dirty);
+
+    bool fits = true;
+    for (int curve : dirty)
+        fits = UpdateSegment(curve) && fits;
+
+    // a segment outgrew its slot, lay out the whole buffer again
+    if (!fits)
+        UploadMesh();
+
+    m_editStats.segments = static_cast<int>(dirty.size());
+    m_editStats.fullUpload = !fits;
+    m_editStats.milliseconds = (glfwGetTime() - start) * 1000.0;
+}
+
+// All geometry of one curve: its piece of both rails, the crossbars and the pillars.
+// The curve is split into chunks and every chunk is generated once for every LOD; the index ranges
+// of a chunk are relative to the slot of the segment.
+void RollerCoaster::GenerateSegment(int curve, TrackMeshData& mesh, std::vector<TrackChunk>& chunks) {
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    chunks.clear();
+
+    // where the rails get a ring: adaptive (flat parts get few slices, loops get many) or uniform
+    if (m_adaptiveTessellation) {
+        m_railParameters[curve] = m_curves[curve].GenerateAdaptiveParameters(m_flatnessTolerance, m_maxBendAngle, m_minRailSteps, m_maxRailSteps);
+    }
+    else {
+        std::vector<float> parameters;
+        for (int i = 0; i <= m_sampler.GetSamplesPerCurve(); ++i)
+            parameters.push_back(static_cast<float>(i) / m_sampler.GetSamplesPerCurve());
+        m_railParameters[curve] = parameters;
+    }
+
+    // Elke 10 eenheden een pilaar, the pillars stand at a fixed arc length interval from the start of the curve
+    std::vector<std::pair<float, glm::vec3>> pillars;
+    float curveStart = m_sampler.GetSample(curve, 0).distance;
+    float curveEnd = curveStart + m_sampler.GetCurveLength(curve);
+    for (float distance = curveStart + m_pillarInterval; distance <= curveEnd; distance += m_pillarInterval) {
+        TrackLocation location = m_sampler.LocateDistance(distance);
+        float t = location.curve == curve ? location.t : 1.0f;
+        pillars.push_back({ t, m_sampler.SampleAtDistance(distance).position });
+    }
+
+    for (int k = 0; k < m_chunksPerSegment; ++k) {
+        float t0 = static_cast<float>(k) / m_chunksPerSegment;
+        float t1 = static_cast<float>(k + 1) / m_chunksPerSegment;
+        bool lastChunk = k == m_chunksPerSegment - 1;
+
+        // the rail rings inside the chunk, the chunk borders always get a ring so neighbouring chunks meet
+        std::vector<float> parameters = { t0 };
+        for (float t : m_railParameters[curve]) {
+            if (t > t0 && t < t1)
+                parameters.push_back(t);
+        }
+        parameters.push_back(t1);
+
+        std::vector<glm::vec3> chunkPillars;
+        for (const auto& pillar : pillars) {
+            if (pillar.first >= t0 && (pillar.first < t1 || lastChunk))
+                chunkPillars.push_back(pillar.second);
         }
+
+        TrackChunk chunk;
+        chunk.segment = static_cast<unsigned int>(curve);
+        size_t firstVertex = mesh.vertices.size() / 6;
+        for (int lod = 0; lod < TRACK_LOD_COUNT; ++lod) {
+            chunk.firstIndex[lod] = static_cast<unsigned int>(mesh.indices.size());
+            GenerateChunk(curve, k, lod, parameters, chunkPillars, mesh);
+            chunk.indexCount[lod] = static_cast<unsigned int>(mesh.indices.size()) - chunk.firstIndex[lod];
+        }
+
+        // bounding box over all the vertices of the chunk
+        chunk.boundsMin = glm::vec3(mesh.vertices[firstVertex * 6], mesh.vertices[firstVertex * 6 + 1], mesh.vertices[firstVertex * 6 + 2]);
+        chunk.boundsMax = chunk.boundsMin;
+        for (size_t v = firstVertex; v < mesh.vertices.size() / 6; ++v) {
+            glm::vec3 position(mesh.vertices[v * 6], mesh.vertices[v * 6 + 1], mesh.vertices[v * 6 + 2]);
+            chunk.boundsMin = glm::min(chunk.boundsMin, position);
+            chunk.boundsMax = glm::max(chunk.boundsMax, position);
+        }
+        chunks.push_back(chunk);
     }
 }
 
-// Hulpmethod om pillars te generaten
-void RollerCoaster::GeneratePillars(float interval) {
-    for (auto& curve : m_curves) {
-        std::vector<glm::vec3> curvePoints = curve.GeneratePoints(32);
-        float accumulated = 0.0f;
-        glm::vec3 last = curvePoints[0];
-        for (size_t i = 1; i < curvePoints.size(); ++i) {
-            float segmentLength = glm::length(curvePoints[i] - last);
-            accumulated += segmentLength;
-            if (accumulated >= interval) {
-                glm::vec3 top = curvePoints[i];
-                glm::vec3 bottom = glm::vec3(top.x, 0.0f, top.z); // Naar de grond
-                unsigned int pillarVAO = createCylinderVAO(
-                    bottom,
-                    top,
-                    0.2f, // Stel deze in als een kleine waarde, bv. 0.2f
-                    m_cylinderSegments
-                );
-                m_cylinderVAOs.push_back(pillarVAO);
-                accumulated = 0.0f;
-            }
-            last = curvePoints[i];
-        }
+// One chunk at one LOD, coarser LODs use fewer vertices per ring and skip crossbars
+void RollerCoaster::GenerateChunk(int curve, int chunk, int lod, const std::vector<float>& parameters,
+    const std::vector<glm::vec3>& pillars, TrackMeshData& mesh) {
+    float halfWidth = m_trackWidth * 0.5f;
+    int ringSegments = std::max(4, static_cast<int>(m_cylinderSegments * m_lodRingScale[lod] + 0.5f));
+
+    // linker- en rechterrail
+    appendRail(mesh, curve, parameters, -halfWidth, m_cylinderRadius, ringSegments, m_railColor);
+    appendRail(mesh, curve, parameters, halfWidth, m_cylinderRadius, ringSegments, m_railColor);
+
+    // dwarsliggers (crossbars), the last sample is the first one of the next curve
+    int samplesPerCurve = m_sampler.GetSamplesPerCurve();
+    int first = chunk * samplesPerCurve / m_chunksPerSegment;
+    int last = (chunk + 1) * samplesPerCurve / m_chunksPerSegment;
+    for (int i = first; i < last; ++i) {
+        if (i % m_lodCrossbarStride[lod] != 0)
+            continue;
+        const TrackSample& sample = m_sampler.GetSample(curve, i);
+        glm::vec3 left = sample.position - sample.right * halfWidth;
+        glm::vec3 right = sample.position + sample.right * halfWidth;
+        appendCrossbar(mesh, left, right, sample.up, sample.tangent, m_crossbarThickness, m_crossbarColor);
+    }
+
+    // Hulpmethod om pillars te generaten
+    for (const glm::vec3& top : pillars) {
+        glm::vec3 bottom = glm::vec3(top.x, 0.0f, top.z); // Naar de grond
+        appendCylinder(mesh, bottom, top, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.2f, ringSegments, m_pillarColor);
+    }
+}
+
+// Picks the LOD of every chunk from its distance to the camera. A chunk only switches when it is
+// clearly past a threshold (m_lodHysteresis), so it doesn't pop back and forth at the border.
+void RollerCoaster::SelectLods(const glm::vec3& cameraPosition) {
+    m_chunkLods.resize(m_chunks.size(), 0);
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        const TrackChunk& chunk = m_chunks[i];
+        // distance to the box, zero inside it
+        glm::vec3 closest = glm::clamp(cameraPosition, chunk.boundsMin, chunk.boundsMax);
+        float distance = glm::length(cameraPosition - closest);
+
+        int lod = m_chunkLods[i];
+        while (lod < TRACK_LOD_COUNT - 1 && distance > m_lodDistances[lod] * (1.0f + m_lodHysteresis))
+            ++lod;
+        while (lod > 0 && distance < m_lodDistances[lod - 1] * (1.0f - m_lodHysteresis))
+            --lod;
+        m_chunkLods[i] = lod;
     }
 }
 
@@ -108,53 +208,237 @@ void RollerCoaster::Render(const glm::mat4& projection, const glm::mat4& view) {
     m_shader.use();
     m_shader.setMat4("projection", projection);
     m_shader.setMat4("view", view);
+    m_shader.setMat4("model", glm::mat4(1.0f));
+
+    // the camera sits at the translation of the inverse view matrix
+    SelectLods(glm::vec3(glm::inverse(view)[3]));
+
+    // only the chunks inside the view frustum are drawn
+    m_visibleChunks.clear();
+    m_bvh.CollectVisible(Frustum(projection * view), m_visibleChunks);
+
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    m_drawBaseVertices.clear();
+    m_stats = TrackRenderStats();
+    for (int i : m_visibleChunks) {
+        const TrackChunk& chunk = m_chunks[i];
+        const TrackSegmentSlot& slot = m_slots[chunk.segment];
+        int lod = m_chunkLods[i];
+        m_drawCounts.push_back(static_cast<GLsizei>(chunk.indexCount[lod]));
+        m_drawOffsets.push_back((const void*)((slot.firstIndex + chunk.firstIndex[lod]) * sizeof(unsigned int)));
+        m_drawBaseVertices.push_back(static_cast<GLint>(slot.firstVertex));
+        m_stats.triangles += chunk.indexCount[lod] / 3;
+    }
+    m_stats.chunks = static_cast<int>(m_chunks.size());
+    m_stats.culledChunks = m_stats.chunks - static_cast<int>(m_visibleChunks.size());
+    if (m_drawCounts.empty())
+        return;
+
+    // the whole track (rails, crossbars and pillars) is drawn with per-vertex colors, one draw per chunk
+    glBindVertexArray(m_VAO);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_INT, m_drawOffsets.data(),
+        static_cast<GLsizei>(m_drawCounts.size()), m_drawBaseVertices.data());
+    glBindVertexArray(0);
+}
 
-    glm::vec3 railColor(0.7f, 0.7f, 0.7f);
-    glm::vec3 crossbarColor(0.2f, 0.2f, 0.2f);
-    glm::vec3 pillarColor(0.4f, 0.4f, 0.4f);
+// builds every segment and uploads the new layout
+void RollerCoaster::UploadMesh() {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    BuildMesh(vertices, indices);
+    uploadBuffers(vertices.data(), vertices.size() / 6, indices.data(), indices.size());
+}
 
-    // Bepaal het aantal VAOs voor rails en crossbars (3 per segment)
-    size_t nonPillarCount = 0;
-    for (auto& curve : m_curves) {
-        std::vector<glm::vec3> curvePoints = curve.GeneratePoints(100);
-        nonPillarCount += (curvePoints.size() - 1) * 3;
+// lays out all segments in one vertex and index array, every slot gets some room to grow
+void RollerCoaster::BuildMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    int curveCount = static_cast<int>(m_curves.size());
+    std::vector<TrackMeshData> meshes(curveCount);
+    m_slots.assign(curveCount, TrackSegmentSlot());
+    m_chunks.clear();
+
+    unsigned int vertexTotal = 0, indexTotal = 0;
+    std::vector<TrackChunk> chunks;
+    for (int curve = 0; curve < curveCount; ++curve) {
+        GenerateSegment(curve, meshes[curve], chunks);
+        m_chunks.insert(m_chunks.end(), chunks.begin(), chunks.end());
+
+        TrackSegmentSlot& slot = m_slots[curve];
+        slot.vertexCount = static_cast<unsigned int>(meshes[curve].vertices.size() / 6);
+        slot.indexCount = static_cast<unsigned int>(meshes[curve].indices.size());
+        slot.vertexCapacity = static_cast<unsigned int>(slot.vertexCount * m_slotSlack);
+        slot.indexCapacity = static_cast<unsigned int>(slot.indexCount * m_slotSlack);
+        slot.firstVertex = vertexTotal;
+        slot.firstIndex = indexTotal;
+
+        vertexTotal += slot.vertexCapacity;
+        indexTotal += slot.indexCapacity;
     }
 
-    for (size_t i = 0; i < m_cylinderVAOs.size(); ++i) {
-        glm::mat4 model = glm::mat4(1.0f);
-        m_shader.setMat4("model", model);
+    // the unused part of a slot stays zero
+    vertices.assign(vertexTotal * 6, 0.0f);
+    indices.assign(indexTotal, 0);
+    for (int curve = 0; curve < curveCount; ++curve) {
+        const TrackSegmentSlot& slot = m_slots[curve];
+        std::copy(meshes[curve].vertices.begin(), meshes[curve].vertices.end(), vertices.begin() + slot.firstVertex * 6);
+        std::copy(meshes[curve].indices.begin(), meshes[curve].indices.end(), indices.begin() + slot.firstIndex);
+    }
+}
 
-        if (i < nonPillarCount) {
-            // Elke derde VAO is een crossbar
-            if ((i % 3) == 2) {
-                m_shader.setVec3("objectColor", crossbarColor);
-            }
-            else {
-                m_shader.setVec3("objectColor", railColor);
+// uploads the whole buffer layout described by m_slots
+void RollerCoaster::uploadBuffers(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+    // GL_DYNAMIC_DRAW, segments are overwritten in place when the track is edited
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * 6 * sizeof(float), vertices, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(m_VAO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_DYNAMIC_DRAW);
+    glBindVertexArray(0);
+
+    m_chunkLods.assign(m_chunks.size(), 0);
+    BuildBVH();
+
+    unsigned int usedVertices = 0;
+    for (const auto& slot : m_slots)
+        usedVertices += slot.vertexCount;
+    unsigned int lodIndices[TRACK_LOD_COUNT] = {};
+    for (const auto& chunk : m_chunks) {
+        for (int lod = 0; lod < TRACK_LOD_COUNT; ++lod)
+            lodIndices[lod] += chunk.indexCount[lod];
+    }
+
+    std::cout << "Track mesh: " << usedVertices << " vertices in " << m_slots.size() << " segments, "
+        << m_chunks.size() << " chunks, triangles per LOD:";
+    for (int lod = 0; lod < TRACK_LOD_COUNT; ++lod)
+        std::cout << " " << lodIndices[lod] / 3;
+    std::cout << std::endl;
+}
+
+// rebuilds one segment and overwrites its slot, returns false when the new geometry doesn't fit
+bool RollerCoaster::UpdateSegment(int curve) {
+    TrackMeshData mesh;
+    std::vector<TrackChunk> chunks;
+    GenerateSegment(curve, mesh, chunks);
+
+    TrackSegmentSlot& slot = m_slots[curve];
+    unsigned int vertexCount = static_cast<unsigned int>(mesh.vertices.size() / 6);
+    unsigned int indexCount = static_cast<unsigned int>(mesh.indices.size());
+    if (vertexCount > slot.vertexCapacity || indexCount > slot.indexCapacity)
+        return false;
+
+    slot.vertexCount = vertexCount;
+    slot.indexCount = indexCount;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, slot.firstVertex * 6 * sizeof(float), mesh.vertices.size() * sizeof(float), mesh.vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(m_VAO);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, slot.firstIndex * sizeof(unsigned int), mesh.indices.size() * sizeof(unsigned int), mesh.indices.data());
+    glBindVertexArray(0);
+
+    std::copy(chunks.begin(), chunks.end(), m_chunks.begin() + curve * m_chunksPerSegment);
+    BuildBVH();
+    return true;
+}
+
+// the tree is small (a few dozen chunks), so after an edit it is simply built again
+void RollerCoaster::BuildBVH() {
+    std::vector<glm::vec3> boxMin, boxMax;
+    for (const auto& chunk : m_chunks) {
+        boxMin.push_back(chunk.boundsMin);
+        boxMax.push_back(chunk.boundsMax);
+    }
+    m_bvh.Build(boxMin, boxMax);
+}
+
+// The BVH finds the chunks that can hold the closest point, within a chunk the centerline between
+// the track samples is tested. The chunk boxes contain the centerline, so they are a valid lower bound.
+TrackPoint RollerCoaster::FindNearestPoint(const glm::vec3& point) const {
+    TrackPoint nearest = { 0, 0.0f, glm::vec3(0.0f), 0.0f };
+    int samplesPerCurve = m_sampler.GetSamplesPerCurve();
+
+    auto testChunk = [&](int index, float best) {
+        const TrackChunk& chunk = m_chunks[index];
+        int curve = static_cast<int>(chunk.segment);
+        int k = index - curve * m_chunksPerSegment;
+        int first = k * samplesPerCurve / m_chunksPerSegment;
+        int last = (k + 1) * samplesPerCurve / m_chunksPerSegment;
+
+        for (int i = first; i < last; ++i) {
+            glm::vec3 a = m_sampler.GetSample(curve, i).position;
+            glm::vec3 b = m_sampler.GetSample(curve, i + 1).position;
+            glm::vec3 ab = b - a;
+            float lengthSquared = glm::dot(ab, ab);
+            float u = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - a, ab) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+            glm::vec3 closest = a + ab * u;
+            float distance = glm::length(point - closest);
+            if (distance < best) {
+                best = distance;
+                nearest = { curve, (i + u) / samplesPerCurve, closest, distance };
             }
         }
-        else {
-            // Dit zijn de pilaren: altijd grijs
-            m_shader.setVec3("objectColor", pillarColor);
-        }
+        return best;
+    };
 
-        glBindVertexArray(m_cylinderVAOs[i]);
-        glDrawElements(GL_TRIANGLES, m_cylinderSegments * 6, GL_UNSIGNED_INT, 0);
-    }
+    float distance;
+    m_bvh.FindNearest(point, testChunk, distance);
+    return nearest;
 }
 
+void RollerCoaster::appendVertex(TrackMeshData& mesh, const glm::vec3& position, const glm::vec3& color) {
+    mesh.vertices.push_back(position.x);
+    mesh.vertices.push_back(position.y);
+    mesh.vertices.push_back(position.z);
+    mesh.vertices.push_back(color.x);
+    mesh.vertices.push_back(color.y);
+    mesh.vertices.push_back(color.z);
+}
 
-unsigned int RollerCoaster::createCylinderVAO(const glm::vec3& start, const glm::vec3& end, float radius, int segments) {
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+// Sweeps one ring profile along the given parameters of a curve, neighbouring slices share their ring.
+// offset moves the tube sideways along the right vector of the track frame.
+// The first ring sits on the last ring of the previous chunk, so the tubes of both chunks meet.
+void RollerCoaster::appendRail(TrackMeshData& mesh, int curve, const std::vector<float>& parameters, float offset, float radius,
+    int segments, const glm::vec3& color) {
+    if (parameters.size() < 2)
+        return;
+
+    unsigned int firstRing = static_cast<unsigned int>(mesh.vertices.size() / 6);
+    unsigned int ringCount = static_cast<unsigned int>(parameters.size());
+
+    for (float t : parameters) {
+        // exact point on the curve, frame interpolated from the track tables
+        TrackSample frame = m_sampler.SampleAt(curve, t);
+        glm::vec3 center = m_curves[curve].GetPoint(t) + frame.right * offset;
+        for (int j = 0; j < segments; ++j) {
+            float angle = 2.0f * glm::pi<float>() * j / segments;
+            appendVertex(mesh, center + frame.right * (radius * cos(angle)) + frame.up * (radius * sin(angle)), color);
+        }
+    }
+
+    // connect every ring with the next one
+    for (unsigned int ring = 0; ring + 1 < ringCount; ++ring) {
+        unsigned int current = firstRing + ring * segments;
+        unsigned int next = current + segments;
+        for (int j = 0; j < segments; ++j) {
+            unsigned int k = (j + 1) % segments;
 
-    glm::vec3 direction = glm::normalize(end - start);
-    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
-    if (glm::length(glm::cross(direction, up)) < 0.01f) {
-        up = glm::vec3(1.0f, 0.0f, 0.0f);
+            mesh.indices.push_back(current + j);
+            mesh.indices.push_back(next + j);
+            mesh.indices.push_back(current + k);
+
+            mesh.indices.push_back(next + j);
+            mesh.indices.push_back(next + k);
+            mesh.indices.push_back(current + k);
+        }
     }
-    glm::vec3 right = glm::normalize(glm::cross(up, direction));
-    up = glm::normalize(glm::cross(direction, right));
+}
+
+// the ring of the cylinder lies in the plane spanned by right and up
+void RollerCoaster::appendCylinder(TrackMeshData& mesh, const glm::vec3& start, const glm::vec3& end, const glm::vec3& right, const glm::vec3& up,
+    float radius, int segments, const glm::vec3& color) {
+    unsigned int baseIndex = static_cast<unsigned int>(mesh.vertices.size() / 6);
 
     // Generate vertices for the cylinder
     for (int i = 0; i <= segments; ++i) {
@@ -165,70 +449,41 @@ unsigned int RollerCoaster::createCylinderVAO(const glm::vec3& start, const glm:
         glm::vec3 offset = right * x + up * y;
 
         // Bottom circle
-        glm::vec3 bottomVertex = start + offset;
-        vertices.push_back(bottomVertex.x);
-        vertices.push_back(bottomVertex.y);
-        vertices.push_back(bottomVertex.z);
+        appendVertex(mesh, start + offset, color);
 
         // Top circle
-        glm::vec3 topVertex = end + offset;
-        vertices.push_back(topVertex.x);
-        vertices.push_back(topVertex.y);
-        vertices.push_back(topVertex.z);
+        appendVertex(mesh, end + offset, color);
     }
 
     // Generate indices for the cylinder
     for (int i = 0; i < segments; ++i) {
-        int bottom1 = i * 2;
-        int top1 = bottom1 + 1;
-        int bottom2 = (i + 1) * 2;
-        int top2 = bottom2 + 1;
+        unsigned int bottom1 = baseIndex + i * 2;
+        unsigned int top1 = bottom1 + 1;
+        unsigned int bottom2 = baseIndex + (i + 1) * 2;
+        unsigned int top2 = bottom2 + 1;
 
         // First triangle
-        indices.push_back(bottom1);
-        indices.push_back(top1);
-        indices.push_back(bottom2);
+        mesh.indices.push_back(bottom1);
+        mesh.indices.push_back(top1);
+        mesh.indices.push_back(bottom2);
 
         // Second triangle
-        indices.push_back(top1);
-        indices.push_back(top2);
-        indices.push_back(bottom2);
+        mesh.indices.push_back(top1);
+        mesh.indices.push_back(top2);
+        mesh.indices.push_back(bottom2);
     }
-
-    // Create VAO, VBO, and EBO
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
 }
 
-unsigned int RollerCoaster::createCrossbarVAO(const glm::vec3& left, const glm::vec3& right, float thickness) {
-    glm::vec3 dir = glm::normalize(right - left);
-    glm::vec3 up = glm::vec3(0, 1, 0);
-    if (glm::abs(glm::dot(dir, up)) > 0.99f) up = glm::vec3(1, 0, 0);
-    glm::vec3 normal = glm::normalize(glm::cross(dir, up));
-    up = glm::normalize(glm::cross(normal, dir));
+// the box runs from left to right, up and forward come from the track frame
+void RollerCoaster::appendCrossbar(TrackMeshData& mesh, const glm::vec3& left, const glm::vec3& right, const glm::vec3& up, const glm::vec3& forward,
+    float thickness, const glm::vec3& color) {
+    unsigned int baseIndex = static_cast<unsigned int>(mesh.vertices.size() / 6);
+
+    const glm::vec3& normal = forward;
     float halfThick = thickness * 0.5f;
 
     // 8 corners of a box
-    std::vector<glm::vec3> corners = {
+    glm::vec3 corners[] = {
         left + up * halfThick + normal * halfThick,
         left + up * halfThick - normal * halfThick,
         left - up * halfThick - normal * halfThick,
@@ -239,14 +494,11 @@ unsigned int RollerCoaster::createCrossbarVAO(const glm::vec3& left, const glm::
         right - up * halfThick + normal * halfThick
     };
 
-    std::vector<float> vertices;
     for (const auto& v : corners) {
-        vertices.push_back(v.x);
-        vertices.push_back(v.y);
-        vertices.push_back(v.z);
+        appendVertex(mesh, v, color);
     }
 
-    std::vector<unsigned int> indices = {
+    const unsigned int boxIndices[] = {
         0,1,2, 2,3,0, // left face
         4,5,6, 6,7,4, // right face
         0,4,7, 7,3,0, // top face
@@ -255,34 +507,140 @@ unsigned int RollerCoaster::createCrossbarVAO(const glm::vec3& left, const glm::
         3,2,6, 6,7,3  // back face
     };
 
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    for (unsigned int index : boxIndices) {
+        mesh.indices.push_back(baseIndex + index);
+    }
+}
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+// Everything the track mesh depends on: the control points and all generation settings
+uint64_t RollerCoaster::ComputeContentHash() const {
+    uint64_t hash = TrackFile::Hash(&TRACK_MESH_VERSION, sizeof(TRACK_MESH_VERSION));
+
+    int samplesPerCurve = m_sampler.GetSamplesPerCurve();
+    hash = TrackFile::Hash(&samplesPerCurve, sizeof(samplesPerCurve), hash);
+    hash = TrackFile::Hash(&m_cylinderRadius, sizeof(m_cylinderRadius), hash);
+    hash = TrackFile::Hash(&m_cylinderSegments, sizeof(m_cylinderSegments), hash);
+    hash = TrackFile::Hash(&m_trackWidth, sizeof(m_trackWidth), hash);
+    hash = TrackFile::Hash(&m_crossbarThickness, sizeof(m_crossbarThickness), hash);
+    hash = TrackFile::Hash(&m_adaptiveTessellation, sizeof(m_adaptiveTessellation), hash);
+    hash = TrackFile::Hash(&m_flatnessTolerance, sizeof(m_flatnessTolerance), hash);
+    hash = TrackFile::Hash(&m_maxBendAngle, sizeof(m_maxBendAngle), hash);
+    hash = TrackFile::Hash(&m_minRailSteps, sizeof(m_minRailSteps), hash);
+    hash = TrackFile::Hash(&m_maxRailSteps, sizeof(m_maxRailSteps), hash);
+    hash = TrackFile::Hash(&m_pillarInterval, sizeof(m_pillarInterval), hash);
+    hash = TrackFile::Hash(&m_slotSlack, sizeof(m_slotSlack), hash);
+    hash = TrackFile::Hash(&m_chunksPerSegment, sizeof(m_chunksPerSegment), hash);
+    hash = TrackFile::Hash(m_lodRingScale, sizeof(m_lodRingScale), hash);
+    hash = TrackFile::Hash(m_lodCrossbarStride, sizeof(m_lodCrossbarStride), hash);
+    for (const glm::vec3& color : { m_railColor, m_crossbarColor, m_pillarColor }) {
+        float rgb[3] = { color.x, color.y, color.z };
+        hash = TrackFile::Hash(rgb, sizeof(rgb), hash);
+    }
 
-    return VAO;
+    for (const auto& segment : m_track.GetSegments()) {
+        for (const auto& point : segment) {
+            float xyz[3] = { point.x, point.y, point.z };
+            hash = TrackFile::Hash(xyz, sizeof(xyz), hash);
+        }
+    }
+    return hash;
 }
 
+// maps the baked mesh and uploads it straight from the mapping, returns false when it is missing or stale
+bool RollerCoaster::LoadMeshCache(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path))
+        return false;
+
+    TrackMeshHeader header;
+    if (file.GetSize() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (std::memcmp(header.magic, "TMSH", 4) != 0 || header.version != TRACK_MESH_VERSION || header.hash != ComputeContentHash()
+        || header.segmentCount != m_curves.size()) {
+        std::cout << "Track mesh cache " << path << " is out of date, rebuilding" << std::endl;
+        return false;
+    }
+
+    size_t slotBytes = header.segmentCount * sizeof(TrackSegmentSlot);
+    size_t chunkBytes = header.segmentCount * m_chunksPerSegment * sizeof(TrackChunk);
+    size_t vertexBytes = static_cast<size_t>(header.vertexCount) * 6 * sizeof(float);
+    size_t indexBytes = static_cast<size_t>(header.indexCount) * sizeof(unsigned int);
+    // in 64 bits, the counts of a broken header could overflow a 32 bit size_t
+    uint64_t fileBytes = uint64_t(sizeof(header)) + slotBytes + chunkBytes
+        + uint64_t(header.vertexCount) * 6 * sizeof(float) + uint64_t(header.indexCount) * sizeof(unsigned int);
+    if (file.GetSize() < fileBytes)
+        return false;
+
+    const unsigned char* data = file.GetData() + sizeof(header);
+    m_slots.resize(header.segmentCount);
+    std::memcpy(m_slots.data(), data, slotBytes);
+    data += slotBytes;
+    m_chunks.resize(header.segmentCount * m_chunksPerSegment);
+    std::memcpy(m_chunks.data(), data, chunkBytes);
+    data += chunkBytes;
+    const unsigned int* indices = reinterpret_cast<const unsigned int*>(data + vertexBytes);
+
+    // a broken file would make the GPU (or a later in-place edit) go outside the buffers: every slot has to
+    // lie in the buffers, every chunk range in its slot and every index has to point at a vertex of its slot
+    for (const TrackSegmentSlot& slot : m_slots) {
+        if (slot.vertexCount > slot.vertexCapacity || slot.indexCount > slot.indexCapacity
+            || uint64_t(slot.firstVertex) + slot.vertexCapacity > header.vertexCount
+            || uint64_t(slot.firstIndex) + slot.indexCapacity > header.indexCount)
+            return false;
+        for (unsigned int i = 0; i < slot.indexCount; ++i) {
+            if (indices[slot.firstIndex + i] >= slot.vertexCount)
+                return false;
+        }
+    }
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        const TrackChunk& chunk = m_chunks[i];
+        if (chunk.segment != i / m_chunksPerSegment)
+            return false;
+        for (int lod = 0; lod < TRACK_LOD_COUNT; ++lod) {
+            if (uint64_t(chunk.firstIndex[lod]) + chunk.indexCount[lod] > m_slots[chunk.segment].indexCount)
+                return false;
+        }
+    }
+
+    // the header keeps the arrays 4 byte aligned
+    uploadBuffers(reinterpret_cast<const float*>(data), header.vertexCount, indices, header.indexCount);
+    std::cout << "Track mesh loaded from " << path << std::endl;
+    return true;
+}
 
+void RollerCoaster::SaveMeshCache(const std::string& path, const std::vector<float>& vertices, const std::vector<unsigned int>& indices) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "ERROR::ROLLERCOASTER::Can't write track mesh cache " << path << std::endl;
+        return;
+    }
 
+    TrackMeshHeader header = { { 'T', 'M', 'S', 'H' }, TRACK_MESH_VERSION, ComputeContentHash(), static_cast<uint32_t>(m_slots.size()),
+        static_cast<uint32_t>(vertices.size() / 6), static_cast<uint32_t>(indices.size()), 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_slots.data()), m_slots.size() * sizeof(TrackSegmentSlot));
+    file.write(reinterpret_cast<const char*>(m_chunks.data()), m_chunks.size() * sizeof(TrackChunk));
+    file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(float));
+    file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(unsigned int));
+}
 
 // Clean up method
 void RollerCoaster::CleanUp() {
-    for (unsigned int vao : m_cylinderVAOs) {
-        glDeleteVertexArrays(1, &vao);
+    if (m_VAO) {
+        glDeleteVertexArrays(1, &m_VAO);
+        glDeleteBuffers(1, &m_VBO);
+        glDeleteBuffers(1, &m_EBO);
+        m_VAO = m_VBO = m_EBO = 0;
     }
-    m_cylinderVAOs.clear(); 
+    m_slots.clear();
+    m_chunks.clear();
+    m_chunkLods.clear();
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    m_drawBaseVertices.clear();
 }
\ No newline at end of file
@@ -1,39 +1,163 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include "Shader.h"
 #include "BezierCurve.h"
+#include "BezierTrack.h"
+#include "TrackBVH.h"
+#include "TrackSampler.h"
+
+// CPU side geometry of one track segment, position + color per vertex
+struct TrackMeshData {
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;	// relative to the first vertex of the segment
+};
+
+// The part of the shared vertex/index buffers that belongs to one track segment
+struct TrackSegmentSlot {
+	unsigned int firstVertex = 0;
+	unsigned int vertexCapacity = 0;
+	unsigned int vertexCount = 0;
+	unsigned int firstIndex = 0;
+	unsigned int indexCapacity = 0;
+	unsigned int indexCount = 0;
+};
+
+static const int TRACK_LOD_COUNT = 3;
+
+// A piece of one segment that picks its own LOD, every LOD has its own index range in the segment slot
+struct TrackChunk {
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	unsigned int segment;
+	unsigned int firstIndex[TRACK_LOD_COUNT];	// relative to the first index of the segment slot
+	unsigned int indexCount[TRACK_LOD_COUNT];
+};
+
+// What the last Render call submitted
+struct TrackRenderStats {
+	int chunks = 0;
+	int culledChunks = 0;
+	int triangles = 0;
+};
+
+// What the last MoveControlPoint call rebuilt
+struct TrackEditStats {
+	int segments = 0;
+	bool fullUpload = false;
+	double milliseconds = 0.0;
+};
+
+// Result of a nearest point query on the centerline of the track
+struct TrackPoint {
+	int curve;
+	float t;
+	glm::vec3 position;
+	float distance;		// from the query point
+};
 
 // This class represents the rollercoaster which consists of multiple Bezier curves.
 // Each Bezier curve is represented by a series of control points.
+// All rails, crossbars and pillars share one vertex and index buffer (position + color per vertex).
+// Every segment owns a slot with some room to grow, so an edited segment is re-uploaded on its own
+// and the whole track is still drawn with a single glMultiDrawElementsBaseVertex call.
+// The buffers can be baked to a mesh cache file, which is mapped and uploaded as is at the next start
+// when its content hash still matches the track.
+// Every segment is split into chunks with a few ring resolutions, the LOD of a chunk follows the camera distance.
+// A BVH over the chunk boxes skips the chunks outside the view frustum and answers nearest point queries.
 class RollerCoaster {
 public:
-	RollerCoaster(std::vector<std::vector<glm::vec3>> bezierSegments, int cylinderSegments);
+	RollerCoaster(std::vector<std::vector<glm::vec3>> bezierSegments, int cylinderSegments, const std::string& meshCachePath = "");
 	~RollerCoaster();
 
 	void Render(const glm::mat4& projection, const glm::mat4& view);
 	void CleanUp();
 
+	// moves a control point, only the segments around it are rebuilt and re-uploaded
+	void MoveControlPoint(int segment, int index, const glm::vec3& position);
+
 	std::vector<BezierCurve>& getCurves() { return m_curves; }
+	const BezierTrack& getTrack() const { return m_track; }
+	const TrackRenderStats& getRenderStats() const { return m_stats; }
+	const TrackEditStats& getEditStats() const { return m_editStats; }
+
+	// closest point on the centerline of the track, found through the chunk BVH
+	TrackPoint FindNearestPoint(const glm::vec3& point) const;
+	const TrackSampler& getSampler() const { return m_sampler; }
 
 	Shader getShader() { return m_shader;  }
 
 
 private:
+	BezierTrack m_track;
 	std::vector<BezierCurve> m_curves;
-	std::vector<unsigned int> m_cylinderVAOs;
+	TrackSampler m_sampler;
 	float m_cylinderRadius = 0.25f;
 	int m_cylinderSegments;
 	int m_trackWidth = 2.0f;
 	float m_crossbarThickness = 0.25f;
 
+	// rail tessellation
+	bool m_adaptiveTessellation = true;
+	float m_flatnessTolerance = 0.02f;				// max distance between the curve and a rail slice
+	float m_maxBendAngle = glm::radians(4.0f);		// max direction change within one rail slice
+	int m_minRailSteps = 4;
+	int m_maxRailSteps = 256;
+	std::vector<std::vector<float>> m_railParameters;	// per curve, the t of every rail ring
+
+	glm::vec3 m_railColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	glm::vec3 m_crossbarColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	glm::vec3 m_pillarColor = glm::vec3(0.4f, 0.4f, 0.4f);
+
 	Shader m_shader;
 
-	void GenerateCylinders();
-	void GeneratePillars(float interval);
-	unsigned int createCylinderVAO(const glm::vec3& start, const glm::vec3& end, float radius, int segments);
-	unsigned int createCrossbarVAO(const glm::vec3& left, const glm::vec3& right, float thickness);
+	float m_pillarInterval = 10.0f;
+	float m_slotSlack = 1.5f;	// extra room per segment slot, so most edits fit in place
+
+	// level of detail
+	int m_chunksPerSegment = 4;
+	float m_lodRingScale[TRACK_LOD_COUNT] = { 1.0f, 0.375f, 0.1875f };	// 32 -> 12 -> 6 vertices per ring
+	int m_lodCrossbarStride[TRACK_LOD_COUNT] = { 1, 2, 4 };
+	float m_lodDistances[TRACK_LOD_COUNT - 1] = { 60.0f, 150.0f };		// switch distance to the next LOD
+	float m_lodHysteresis = 0.1f;
+	std::vector<TrackChunk> m_chunks;
+	std::vector<int> m_chunkLods;
+
+	// culling
+	TrackBVH m_bvh;
+	std::vector<int> m_visibleChunks;
+	TrackRenderStats m_stats;
+	TrackEditStats m_editStats;
+
+	unsigned int m_VAO = 0, m_VBO = 0, m_EBO = 0;
+	std::vector<TrackSegmentSlot> m_slots;
+
+	// one draw per chunk, all submitted at once
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+	std::vector<GLint> m_drawBaseVertices;
+
+	void GenerateSegment(int curve, TrackMeshData& mesh, std::vector<TrackChunk>& chunks);
+	void GenerateChunk(int curve, int chunk, int lod, const std::vector<float>& parameters,
+		const std::vector<glm::vec3>& pillars, TrackMeshData& mesh);
+	void SelectLods(const glm::vec3& cameraPosition);
+	void BuildBVH();
+	void UploadMesh();
+	void BuildMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices);
+	void uploadBuffers(const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+	bool UpdateSegment(int curve);
+	uint64_t ComputeContentHash() const;
+	bool LoadMeshCache(const std::string& path);
+	void SaveMeshCache(const std::string& path, const std::vector<float>& vertices, const std::vector<unsigned int>& indices) const;
+	void appendRail(TrackMeshData& mesh, int curve, const std::vector<float>& parameters, float offset, float radius, int segments, const glm::vec3& color);
+	void appendCylinder(TrackMeshData& mesh, const glm::vec3& start, const glm::vec3& end, const glm::vec3& right, const glm::vec3& up,
+		float radius, int segments, const glm::vec3& color);
+	void appendCrossbar(TrackMeshData& mesh, const glm::vec3& left, const glm::vec3& right, const glm::vec3& up, const glm::vec3& forward,
+		float thickness, const glm::vec3& color);
+	void appendVertex(TrackMeshData& mesh, const glm::vec3& position, const glm::vec3& color);
 
 
 
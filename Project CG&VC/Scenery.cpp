@@ -1 +1,3 @@
 #include "Scenery.h"
+
+SceneryRenderStats Scenery::s_stats;
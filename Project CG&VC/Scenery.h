@@ -4,6 +4,12 @@
 #include "Model.h"
 #include "Shader.h"
 
+// What the scenery drew in the last frame, per level of detail
+struct SceneryRenderStats {
+    int instances[Model::MAX_LODS] = {};
+    unsigned int triangles[Model::MAX_LODS] = {};
+};
+
 class Scenery {
 public:
     Scenery(const std::string& modelPath, const glm::vec3& position, float scale = 1.0f)
@@ -12,19 +18,28 @@ public:
 
     virtual ~Scenery() = default;
 
+    // draws the level of detail that fits the size on screen
     virtual void Render(const glm::mat4& projection, const glm::mat4& view) {
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, m_position);
         model = glm::rotate(model, m_rotation.y, glm::vec3(0, 1, 0)); // Y-as
         model = glm::scale(model, glm::vec3(m_scale));
 
+        int lod = m_model.SelectLod(projection, view, model);
+        s_stats.instances[lod]++;
+        s_stats.triangles[lod] += m_model.GetTriangleCount(lod);
+
         m_shader.use();
         m_shader.setMat4("projection", projection);
         m_shader.setMat4("view", view);
         m_shader.setMat4("model", model);
-        m_model.Draw(m_shader);
+        m_model.Draw(m_shader, lod);
     }
 
+    static const SceneryRenderStats& GetRenderStats() { return s_stats; }
+    // call at the start of a frame
+    static void ResetRenderStats() { s_stats = SceneryRenderStats(); }
+
     const glm::vec3& GetPosition() const { return m_position; }
     void SetPosition(const glm::vec3& pos) { m_position = pos; }
     float GetScale() const { return m_scale; }
@@ -54,4 +69,6 @@ protected:
     float m_scale;
     glm::vec3 m_rotation = glm::vec3(0.0f); 
 
+    static SceneryRenderStats s_stats;
+
 };
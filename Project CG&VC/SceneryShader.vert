@@ -1,21 +1,23 @@
 #version 330 core
 
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in vec2 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "Packing.GLSL"
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoords = aTexCoords;
+    FragPos = vec3(model * vec4(aPos * positionScale + positionOffset, 1.0));
+    Normal = mat3(transpose(inverse(model))) * decodeNormal(aNormal);
+    TexCoords = aTexCoords * uvScale + uvOffset;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -1,5 +1,32 @@
 #include "Shader.h"
 
+// replaces every line #include "file" with that file, looked up next to the shader (GLSL itself has no includes)
+static std::string expandIncludes(const std::string& code, const std::string& shaderPath) {
+	const std::string directive = "#include \"";
+	size_t slash = shaderPath.find_last_of("\\/");
+	std::string directory = slash == std::string::npos ? "" : shaderPath.substr(0, slash + 1);
+
+	std::stringstream source(code);
+	std::string expanded, line;
+	while (std::getline(source, line)) {
+		size_t end = line.rfind('"');
+		if (line.compare(0, directive.size(), directive) != 0 || end < directive.size()) {
+			expanded += line + "\n";
+			continue;
+		}
+		std::string includePath = directory + line.substr(directive.size(), end - directive.size());
+		std::ifstream includeFile(includePath);
+		if (!includeFile) {
+			std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << includePath << std::endl;
+			continue;
+		}
+		std::stringstream includeStream;
+		includeStream << includeFile.rdbuf();
+		expanded += includeStream.str() + "\n";
+	}
+	return expanded;
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 	// 1. retrieve the vertex/fragment source code from filePath
 	std::string vertexCode;
@@ -21,8 +48,8 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 		vShaderFile.close();
 		fShaderFile.close();
 		// convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
+		vertexCode = expandIncludes(vShaderStream.str(), vertexPath);
+		fragmentCode = expandIncludes(fShaderStream.str(), fragmentPath);
 	}
 	catch (std::ifstream::failure& e) {
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
@@ -140,4 +167,10 @@ void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 
 void Shader::setFloatArray(const std::string& name, const float* values, int count) const {
 	glUniform1fv(glGetUniformLocation(ID, name.c_str()), count, values);
+}
+
+void Shader::bindUniformBlock(const std::string& name, unsigned int bindingPoint) const {
+	unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(ID, index, bindingPoint);
 }
\ No newline at end of file
@@ -35,4 +35,6 @@ public:
     void setMat3(const std::string& name, const glm::mat3& mat) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
     void setFloatArray(const std::string& name, const float* values, int count) const;
+    // links a uniform block to a binding point, does nothing when the shader doesn't use the block
+    void bindUniformBlock(const std::string& name, unsigned int bindingPoint) const;
 };
\ No newline at end of file
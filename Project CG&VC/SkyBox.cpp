@@ -1,5 +1,4 @@
 #include "SkyBox.h"
-#include "stb_image.h"
 #include <iostream>
 
 static float skyboxVertices[] = {
@@ -70,7 +69,7 @@ SkyBox::SkyBox(const char* vertPath, const char* fragPath)
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    cubemapTexture = loadCubemap(faces);
+    cubemapTexture = TextureCache::GetCubemap(faces, TextureSettings::Cubemap());
 }
 
 SkyBox::~SkyBox() {
@@ -87,36 +86,14 @@ void SkyBox::Render(const glm::mat4& projection, const glm::mat4& view) {
 
     glBindVertexArray(VAO);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture->id);
     glDrawArrays(GL_TRIANGLES, 0, 36);
     glBindVertexArray(0);
     glDepthFunc(GL_LESS);
 }
 
-unsigned int SkyBox::loadCubemap(const std::vector<std::string>& faces) {
-    stbi_set_flip_vertically_on_load(false);
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+void SkyBox::Prefetch() {
+    for (const std::string& face : faces)
+        TextureCache::Prefetch(face, TextureSettings::Cubemap());
+}
 
-    return textureID;
-}
\ No newline at end of file
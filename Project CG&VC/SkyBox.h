@@ -4,19 +4,20 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <string>
+#include <memory>
 #include "Shader.h"
+#include "TextureCache.h"
 
 class SkyBox {
 public:
     SkyBox(const char* vertPath, const char* fragPath);
+    static void Prefetch();
     ~SkyBox();
 
     void Render(const glm::mat4& projection, const glm::mat4& view);
 
 private:
     unsigned int VAO, VBO;
-    unsigned int cubemapTexture;
+    std::shared_ptr<TextureResource> cubemapTexture;
     Shader shader;
-
-    unsigned int loadCubemap(const std::vector<std::string>& faces);
 };
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "TextureCache.h"
+#include "AssetLoader.h"
+
+#include <glad/glad.h>
+#include <iostream>
+
+// S3TC is an extension, but every desktop driver has it; glad only defines these when it was generated with it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+TextureSettings TextureSettings::Colormap() {
+    return { GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true, true, 0 };
+}
+
+TextureSettings TextureSettings::Terrain() {
+    return { GL_MIRRORED_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, false, false, 0 };
+}
+
+TextureSettings TextureSettings::Sprite() {
+    return { GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false, true, 4 };
+}
+
+TextureSettings TextureSettings::Cubemap() {
+    return { GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, false, false, 0 };
+}
+
+std::string TextureSettings::Key() const {
+    return std::to_string(wrap) + "," + std::to_string(minFilter) + "," + std::to_string(magFilter) + ","
+        + (srgb ? "srgb," : "linear,") + (flip ? "flip," : "") + std::to_string(channels);
+}
+
+TextureResource::~TextureResource() {
+    glDeleteTextures(1, &id);
+}
+
+std::unordered_map<std::string, std::weak_ptr<TextureResource>>& TextureCache::entries() {
+    static std::unordered_map<std::string, std::weak_ptr<TextureResource>> map;
+    return map;
+}
+
+TextureCacheStats& TextureCache::counters() {
+    static TextureCacheStats stats;
+    return stats;
+}
+
+std::shared_ptr<TextureResource> TextureCache::find(const std::string& key) {
+    auto entry = entries().find(key);
+    if (entry == entries().end())
+        return nullptr;
+    std::shared_ptr<TextureResource> texture = entry->second.lock();
+    if (texture)
+        ++counters().hits;
+    return texture;
+}
+
+void TextureCache::store(const std::string& key, const std::shared_ptr<TextureResource>& texture) {
+    texture->key = key;
+    entries()[key] = texture;
+    ++counters().uploads;
+}
+
+static bool usesMipmaps(int minFilter) {
+    return minFilter == GL_LINEAR_MIPMAP_LINEAR || minFilter == GL_LINEAR_MIPMAP_NEAREST
+        || minFilter == GL_NEAREST_MIPMAP_LINEAR || minFilter == GL_NEAREST_MIPMAP_NEAREST;
+}
+
+static GLenum pixelFormat(int components) {
+    if (components == 1)
+        return GL_RED;
+    if (components == 2)
+        return GL_RG;
+    if (components == 4)
+        return GL_RGBA;
+    return GL_RGB;
+}
+
+// the levels of a baked texture, all of them when the sampler uses mipmaps; returns the uploaded bytes
+static size_t uploadBaked(GLenum target, const TextureFileView& texture, bool srgb, bool mipmaps) {
+    GLenum internalFormat = texture.glInternalFormat;
+    if (srgb) {
+        if (internalFormat == GL_RGBA8)
+            internalFormat = GL_SRGB8_ALPHA8;
+        else if (internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+            internalFormat = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        else if (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+            internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+    }
+
+    size_t levels = mipmaps ? texture.levels.size() : 1;
+    size_t bytes = 0;
+    for (size_t level = 0; level < levels; ++level) {
+        const TextureLevel& mip = texture.levels[level];
+        if (texture.compressed)
+            glCompressedTexImage2D(target, static_cast<GLint>(level), internalFormat, mip.width, mip.height, 0, mip.size, mip.data);
+        else
+            glTexImage2D(target, static_cast<GLint>(level), internalFormat, mip.width, mip.height, 0, texture.glFormat, texture.glType, mip.data);
+        bytes += mip.size;
+    }
+    return bytes;
+}
+
+std::shared_ptr<TextureResource> TextureCache::Get(const std::string& path, const TextureSettings& settings) {
+    std::string key = path + "|" + settings.Key();
+    std::shared_ptr<TextureResource> texture = find(key);
+    if (texture)
+        return texture;
+
+    std::shared_ptr<const ImageData> image = AssetLoader::Get().TakeImage(path, settings.channels, settings.flip, true);
+    AssetUploadTimer timer(path);
+
+    texture = std::make_shared<TextureResource>();
+    texture->target = GL_TEXTURE_2D;
+    glGenTextures(1, &texture->id);
+    store(key, texture);
+
+    // a baked texture brings its mip levels, nothing is decoded or generated here
+    if (image->IsBaked()) {
+        bool mipmaps = usesMipmaps(settings.minFilter);
+        glBindTexture(GL_TEXTURE_2D, texture->id);
+        texture->bytes = uploadBaked(GL_TEXTURE_2D, image->texture, settings.srgb, mipmaps);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmaps ? static_cast<GLint>(image->texture.levels.size()) - 1 : 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, settings.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, settings.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, settings.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, settings.magFilter);
+        texture->width = image->width;
+        texture->height = image->height;
+        return texture;
+    }
+
+    if (!image->pixels) {
+        std::cout << "Failed to load texture: " << path << std::endl;
+        return texture;
+    }
+
+    GLenum format = pixelFormat(image->components);
+    GLenum internalFormat = settings.srgb ? (image->components == 4 ? GL_SRGB_ALPHA : GL_SRGB) : format;
+    bool mipmaps = usesMipmaps(settings.minFilter);
+
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image->width, image->height, 0, format, GL_UNSIGNED_BYTE, image->pixels);
+    if (mipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, settings.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, settings.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, settings.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, settings.magFilter);
+
+    // the driver keeps 3 channel textures as 4 channels
+    size_t pixelBytes = image->components == 3 ? 4 : image->components;
+    texture->width = image->width;
+    texture->height = image->height;
+    texture->bytes = static_cast<size_t>(image->width) * image->height * pixelBytes * (mipmaps ? 4 : 3) / 3;
+    return texture;
+}
+
+void TextureCache::Prefetch(const std::string& path, const TextureSettings& settings) {
+    AssetLoader::Get().PrefetchImage(path, settings.channels, settings.flip, true);
+}
+
+std::shared_ptr<TextureResource> TextureCache::GetCubemap(const std::vector<std::string>& faces, const TextureSettings& settings) {
+    std::string key = "cubemap";
+    for (const std::string& face : faces)
+        key += "|" + face;
+    key += "|" + settings.Key();
+    std::shared_ptr<TextureResource> texture = find(key);
+    if (texture)
+        return texture;
+
+    texture = std::make_shared<TextureResource>();
+    texture->target = GL_TEXTURE_CUBE_MAP;
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture->id);
+    store(key, texture);
+
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        std::shared_ptr<const ImageData> image = AssetLoader::Get().TakeImage(faces[i], settings.channels, settings.flip, true);
+        if (image->IsBaked()) {
+            AssetUploadTimer timer(faces[i]);
+            texture->bytes += uploadBaked(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, image->texture, settings.srgb, false);
+            texture->width = image->width;
+            texture->height = image->height;
+        }
+        else if (image->pixels) {
+            AssetUploadTimer timer(faces[i]);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, image->width, image->height, 0, GL_RGB, GL_UNSIGNED_BYTE, image->pixels);
+            texture->width = image->width;
+            texture->height = image->height;
+            texture->bytes += static_cast<size_t>(image->width) * image->height * 4;
+        }
+        else {
+            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
+        }
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, settings.minFilter);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, settings.magFilter);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, settings.wrap);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, settings.wrap);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, settings.wrap);
+    return texture;
+}
+
+std::shared_ptr<TextureResource> TextureCache::GetWhite() {
+    const std::string key = "white|";
+    std::shared_ptr<TextureResource> texture = find(key);
+    if (texture)
+        return texture;
+
+    texture = std::make_shared<TextureResource>();
+    texture->target = GL_TEXTURE_2D;
+    glGenTextures(1, &texture->id);
+    store(key, texture);
+
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    texture->width = 1;
+    texture->height = 1;
+    texture->bytes = sizeof(white);
+    return texture;
+}
+
+TextureCacheStats TextureCache::GetStats() {
+    TextureCacheStats stats = counters();
+    for (const auto& entry : entries()) {
+        std::shared_ptr<TextureResource> texture = entry.second.lock();
+        if (!texture)
+            continue;
+        ++stats.textures;
+        stats.references += texture.use_count() - 1;	// without the lock above
+        stats.residentBytes += texture->bytes;
+    }
+    return stats;
+}
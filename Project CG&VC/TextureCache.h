@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// How a texture is decoded and sampled, part of the cache key: the same file with other settings is another texture
+struct TextureSettings {
+	int wrap;				// GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE
+	int minFilter;			// a mipmap filter also makes the mipmaps
+	int magFilter;
+	bool srgb;				// colour textures that are lit in linear space
+	bool flip;				// stbi flip on load
+	int channels;			// 0 = as in the file
+
+	static TextureSettings Colormap();		// colormaps of models
+	static TextureSettings Terrain();		// tiled terrain and water textures
+	static TextureSettings Sprite();		// particles and overlays, RGBA without mipmaps
+	static TextureSettings Cubemap();
+
+	std::string Key() const;
+};
+
+// One texture on the GPU, deleted when the last handle is gone
+struct TextureResource {
+	std::string key;
+	unsigned int id = 0;
+	unsigned int target = 0;	// GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+	int width = 0;
+	int height = 0;
+	size_t bytes = 0;			// resident size, with the mipmaps
+
+	TextureResource() = default;
+	~TextureResource();
+	TextureResource(const TextureResource&) = delete;
+	TextureResource& operator=(const TextureResource&) = delete;
+};
+
+struct TextureCacheStats {
+	size_t textures = 0;		// resident right now
+	size_t references = 0;		// handles to them
+	size_t uploads = 0;			// since the start
+	size_t hits = 0;			// requests that reused a resident texture
+	size_t residentBytes = 0;
+};
+
+/*
+* Loads every texture once per path and settings and hands out shared handles
+* containts:
+*		- a map from key to a weak reference, the texture is deleted when the last handle is gone
+*		- the upload of a decoded image (AssetLoader) with the given sampler and colour space
+*		- cube maps, keyed by their six faces
+*		- the resident texture memory
+*/
+class TextureCache {
+public:
+	static std::shared_ptr<TextureResource> Get(const std::string& path, const TextureSettings& settings);
+	// starts decoding on the AssetLoader threads, with the decode settings Get will ask for
+	static void Prefetch(const std::string& path, const TextureSettings& settings);
+	static std::shared_ptr<TextureResource> GetCubemap(const std::vector<std::string>& faces, const TextureSettings& settings);
+	// 1x1 white texture for materials without a colormap, they are drawn in the plain lit colour
+	static std::shared_ptr<TextureResource> GetWhite();
+	static TextureCacheStats GetStats();
+
+private:
+	static std::unordered_map<std::string, std::weak_ptr<TextureResource>>& entries();
+	static TextureCacheStats& counters();
+	static std::shared_ptr<TextureResource> find(const std::string& key);
+	static void store(const std::string& key, const std::shared_ptr<TextureResource>& texture);
+};
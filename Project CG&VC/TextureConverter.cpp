@@ -0,0 +1,113 @@
+// Offline converter: bakes images into the .ktx (all mip levels, optionally BC1/BC3) that the TextureCache loads
+//
+// usage: TextureConverter [--bc] [--force] [--top-down] [files or directories...]
+// Without inputs it bakes the textures of the scene: .\textures and the skybox top down (they are loaded
+// without flipping), the model textures, the fire and the chroma key overlay bottom up.
+// --bc compresses (BC1 for opaque images, BC3 with alpha), --top-down keeps the row order of the file for
+// the inputs that follow it. A baked file that still belongs to its source is skipped, --force bakes everything again.
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TextureFile.h"
+#include "stb_image.h"
+
+namespace fs = std::filesystem;
+
+static bool isImage(const fs::path& path) {
+	std::string extension = path.extension().string();
+	for (char& c : extension)
+		c = static_cast<char>(tolower(c));
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+}
+
+// returns false when the image can't be decoded or written
+static bool convert(const std::string& path, bool bottomUp, bool compress, bool force) {
+	std::string bakedPath = TextureFile::BakedPath(path);
+	uint64_t sourceHash = TextureFile::HashSource(path);
+
+	if (!force) {
+		MappedFile baked;
+		TextureFileView view;
+		if (TextureFile::Map(baked, bakedPath, sourceHash, bottomUp, view) && view.compressed == compress) {
+			std::cout << "up to date  " << path << std::endl;
+			return true;
+		}
+	}
+
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(bottomUp ? 1 : 0);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "ERROR::CONVERTER::can't decode " << path << std::endl;
+		return false;
+	}
+	TextureFileData data = TextureFile::Build(pixels, width, height, bottomUp, compress);
+	stbi_image_free(pixels);
+
+	size_t bytes = 0;
+	for (const std::vector<unsigned char>& level : data.levels)
+		bytes += level.size();
+	try {
+		TextureFile::Save(bakedPath, data, sourceHash);
+	}
+	catch (const std::exception& e) {
+		std::cout << "ERROR::CONVERTER::" << e.what() << std::endl;
+		return false;
+	}
+	std::cout << "baked       " << path << " (" << width << "x" << height << ", " << data.levels.size() << " levels, "
+		<< (compress ? (data.glInternalFormat == 0x83F0 ? "BC1" : "BC3") : "RGBA8") << ", " << bytes / 1024 << " KB)" << std::endl;
+	return true;
+}
+
+struct Input {
+	std::string path;
+	bool bottomUp;
+};
+
+int main(int argc, char** argv) {
+	bool force = false, compress = false, bottomUp = true;
+	std::vector<Input> inputs;
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--force")
+			force = true;
+		else if (argument == "--bc")
+			compress = true;
+		else if (argument == "--top-down")
+			bottomUp = false;
+		else
+			inputs.push_back({ argument, bottomUp });
+	}
+	if (inputs.empty()) {
+		inputs.push_back({ ".\\textures", false });
+		inputs.push_back({ ".\\models\\skybox", false });
+		inputs.push_back({ ".\\models\\cart\\Textures", true });
+		inputs.push_back({ ".\\models\\lamp\\Textures", true });
+		inputs.push_back({ ".\\models\\rollercoaster\\Textures", true });
+		inputs.push_back({ ".\\models\\scenery\\Textures", true });
+		inputs.push_back({ ".\\models\\ChromaKeying\\dog.jpeg", true });
+		inputs.push_back({ ".\\fire.png", true });
+	}
+
+	int failed = 0;
+	for (const Input& input : inputs) {
+		std::error_code error;
+		if (fs::is_directory(input.path, error)) {
+			for (const auto& entry : fs::recursive_directory_iterator(input.path, error)) {
+				if (entry.is_regular_file() && isImage(entry.path()) && !convert(entry.path().string(), input.bottomUp, compress, force))
+					++failed;
+			}
+		}
+		else if (!convert(input.path, input.bottomUp, compress, force)) {
+			++failed;
+		}
+	}
+
+	if (failed > 0)
+		std::cout << failed << " texture(s) failed" << std::endl;
+	return failed > 0 ? 1 : 0;
+}
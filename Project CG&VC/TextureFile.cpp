@@ -0,0 +1,397 @@
+#include "TextureFile.h"
+#include "MappedFile.h"
+#include "TrackFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// the GL enums that end up in the header, the converter doesn't link OpenGL
+static const uint32_t KTX_GL_UNSIGNED_BYTE = 0x1401;
+static const uint32_t KTX_GL_RGB = 0x1907;
+static const uint32_t KTX_GL_RGBA = 0x1908;
+static const uint32_t KTX_GL_RGBA8 = 0x8058;
+static const uint32_t KTX_GL_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;	// BC1
+static const uint32_t KTX_GL_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;	// BC3
+
+static const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const uint32_t KTX_ENDIANNESS = 0x04030201;
+static const char* SOURCE_HASH_KEY = "CGVC.sourceHash";
+static const char* ORIENTATION_KEY = "KTXorientation";
+static const char* BOTTOM_UP = "S=r,T=u";
+static const char* TOP_DOWN = "S=r,T=d";
+
+struct KtxHeader {
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64, "KtxHeader is written as is");
+
+static size_t padded(size_t size) {
+    return (size + 3) & ~size_t(3);
+}
+
+static uint32_t blockBytes(uint32_t internalFormat) {
+    return internalFormat == KTX_GL_COMPRESSED_RGB_S3TC_DXT1 ? 8 : 16;
+}
+
+bool TextureFile::Map(MappedFile& file, const std::string& path, uint64_t sourceHash, bool bottomUp, TextureFileView& view) {
+    if (!file.Open(path))
+        return false;
+
+    KtxHeader header;
+    if (file.GetSize() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (std::memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 || header.endianness != KTX_ENDIANNESS)
+        return false;
+    // 2D textures only, a cube map is made from six of them
+    if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1 || header.numberOfMipmapLevels == 0)
+        return false;
+    bool compressed = header.glType == 0;
+    if (compressed ? (header.glInternalFormat != KTX_GL_COMPRESSED_RGB_S3TC_DXT1 && header.glInternalFormat != KTX_GL_COMPRESSED_RGBA_S3TC_DXT5)
+        : (header.glType != KTX_GL_UNSIGNED_BYTE || header.glFormat != KTX_GL_RGBA))
+        return false;
+
+    // key/value pairs: the source hash and the row order
+    const unsigned char* data = file.GetData();
+    size_t offset = sizeof(header);
+    size_t end = offset + header.bytesOfKeyValueData;
+    if (file.GetSize() < end)
+        return false;
+    uint64_t fileHash = 0;
+    bool fileBottomUp = true;	// the default of KTX
+    while (offset + sizeof(uint32_t) <= end) {
+        uint32_t length;
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > end)
+            return false;
+        const char* pair = reinterpret_cast<const char*>(data + offset);
+        size_t keyLength = strnlen(pair, length);
+        std::string key(pair, keyLength);
+        if (keyLength < length) {
+            const char* value = pair + keyLength + 1;
+            size_t valueLength = length - keyLength - 1;
+            if (key == SOURCE_HASH_KEY && valueLength == sizeof(fileHash))
+                std::memcpy(&fileHash, value, sizeof(fileHash));
+            else if (key == ORIENTATION_KEY)
+                fileBottomUp = std::string(value, strnlen(value, valueLength)).find("T=d") == std::string::npos;
+        }
+        offset += padded(length);
+    }
+    if (sourceHash != 0 && fileHash != sourceHash)
+        return false;
+    if (fileBottomUp != bottomUp)
+        return false;
+
+    view.glInternalFormat = header.glInternalFormat;
+    view.glFormat = header.glFormat;
+    view.glType = header.glType;
+    view.compressed = compressed;
+    view.levels.clear();
+    offset = end;
+    for (uint32_t level = 0; level < header.numberOfMipmapLevels; ++level) {
+        TextureLevel mip;
+        mip.width = std::max(header.pixelWidth >> level, 1u);
+        mip.height = std::max(header.pixelHeight >> level, 1u);
+        size_t expected = compressed ? size_t((mip.width + 3) / 4) * ((mip.height + 3) / 4) * blockBytes(header.glInternalFormat)
+            : size_t(mip.width) * mip.height * 4;
+
+        if (file.GetSize() < offset + sizeof(mip.size))
+            return false;
+        std::memcpy(&mip.size, data + offset, sizeof(mip.size));
+        offset += sizeof(mip.size);
+        if (mip.size != expected || file.GetSize() < offset + mip.size)
+            return false;
+        mip.data = data + offset;
+        offset += padded(mip.size);
+        view.levels.push_back(mip);
+    }
+    return true;
+}
+
+static void writeKeyValue(std::ofstream& file, const std::string& key, const void* value, uint32_t valueLength) {
+    uint32_t length = static_cast<uint32_t>(key.size() + 1) + valueLength;
+    static const char zeros[4] = {};
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(key.c_str(), key.size() + 1);
+    file.write(static_cast<const char*>(value), valueLength);
+    file.write(zeros, padded(length) - length);
+}
+
+void TextureFile::Save(const std::string& path, const TextureFileData& data, uint64_t sourceHash) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("TextureFile: can't write " + path);
+
+    const char* orientation = data.bottomUp ? BOTTOM_UP : TOP_DOWN;
+    uint32_t keyValueBytes = static_cast<uint32_t>(sizeof(uint32_t) + padded(std::strlen(SOURCE_HASH_KEY) + 1 + sizeof(sourceHash))
+        + sizeof(uint32_t) + padded(std::strlen(ORIENTATION_KEY) + 1 + std::strlen(orientation) + 1));
+
+    KtxHeader header = {};
+    std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = KTX_ENDIANNESS;
+    header.glType = data.compressed ? 0 : KTX_GL_UNSIGNED_BYTE;
+    header.glTypeSize = 1;
+    header.glFormat = data.compressed ? 0 : KTX_GL_RGBA;
+    header.glInternalFormat = data.glInternalFormat;
+    header.glBaseInternalFormat = data.glInternalFormat == KTX_GL_COMPRESSED_RGB_S3TC_DXT1 ? KTX_GL_RGB : KTX_GL_RGBA;
+    header.pixelWidth = data.widths.empty() ? 0 : data.widths[0];
+    header.pixelHeight = data.heights.empty() ? 0 : data.heights[0];
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(data.levels.size());
+    header.bytesOfKeyValueData = keyValueBytes;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writeKeyValue(file, SOURCE_HASH_KEY, &sourceHash, sizeof(sourceHash));
+    writeKeyValue(file, ORIENTATION_KEY, orientation, static_cast<uint32_t>(std::strlen(orientation) + 1));
+
+    static const char zeros[4] = {};
+    for (const std::vector<unsigned char>& level : data.levels) {
+        uint32_t size = static_cast<uint32_t>(level.size());
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(level.data()), level.size());
+        file.write(zeros, padded(size) - size);
+    }
+}
+
+uint64_t TextureFile::HashSource(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path))
+        return 0;
+    return TrackFile::Hash(file.GetData(), file.GetSize());
+}
+
+TextureFileView TextureFile::View(const TextureFileData& data) {
+    TextureFileView view;
+    view.glInternalFormat = data.glInternalFormat;
+    view.glFormat = data.compressed ? 0 : KTX_GL_RGBA;
+    view.glType = data.compressed ? 0 : KTX_GL_UNSIGNED_BYTE;
+    view.compressed = data.compressed;
+    for (size_t i = 0; i < data.levels.size(); ++i) {
+        TextureLevel level;
+        level.width = data.widths[i];
+        level.height = data.heights[i];
+        level.data = data.levels[i].data();
+        level.size = static_cast<uint32_t>(data.levels[i].size());
+        view.levels.push_back(level);
+    }
+    return view;
+}
+
+namespace {
+    // the images are sRGB, the mip levels are averaged in linear light so they don't get darker
+    float toLinear(unsigned char value) {
+        float c = value / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    unsigned char toSrgb(float linear) {
+        float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+        return static_cast<unsigned char>(std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f));
+    }
+
+    std::vector<unsigned char> downsample(const std::vector<unsigned char>& source, uint32_t width, uint32_t height, uint32_t newWidth, uint32_t newHeight) {
+        static float linear[256];
+        static bool initialized = false;
+        if (!initialized) {
+            for (int i = 0; i < 256; ++i)
+                linear[i] = toLinear(static_cast<unsigned char>(i));
+            initialized = true;
+        }
+
+        std::vector<unsigned char> result(size_t(newWidth) * newHeight * 4);
+        for (uint32_t y = 0; y < newHeight; ++y) {
+            for (uint32_t x = 0; x < newWidth; ++x) {
+                // a side of 1 pixel is taken twice
+                uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+                const unsigned char* texels[4] = {
+                    &source[(size_t(y0) * width + x0) * 4], &source[(size_t(y0) * width + x1) * 4],
+                    &source[(size_t(y1) * width + x0) * 4], &source[(size_t(y1) * width + x1) * 4] };
+                unsigned char* out = &result[(size_t(y) * newWidth + x) * 4];
+                for (int c = 0; c < 3; ++c)
+                    out[c] = toSrgb((linear[texels[0][c]] + linear[texels[1][c]] + linear[texels[2][c]] + linear[texels[3][c]]) * 0.25f);
+                out[3] = static_cast<unsigned char>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+            }
+        }
+        return result;
+    }
+
+    uint16_t to565(const float color[3]) {
+        int r = std::min(std::max(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0), 31);
+        int g = std::min(std::max(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0), 63);
+        int b = std::min(std::max(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0), 31);
+        return static_cast<uint16_t>(r << 11 | g << 5 | b);
+    }
+
+    void from565(uint16_t color, int out[3]) {
+        int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+        out[0] = r << 3 | r >> 2;
+        out[1] = g << 2 | g >> 4;
+        out[2] = b << 3 | b >> 2;
+    }
+
+    // BC1 colour block: the end points are the extremes along the main axis of the colours, every
+    // pixel takes the closest of the four palette colours
+    void encodeColorBlock(const unsigned char pixels[16][4], unsigned char* out) {
+        float mean[3] = {};
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 3; ++c)
+                mean[c] += pixels[i][c] / 16.0f;
+        }
+        float covariance[6] = {};	// rr rg rb gg gb bb
+        for (int i = 0; i < 16; ++i) {
+            float d[3] = { pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2] };
+            covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+            covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+        }
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+            float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < 3; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        int minIndex = 0, maxIndex = 0;
+        float minProjection = 1e30f, maxProjection = -1e30f;
+        for (int i = 0; i < 16; ++i) {
+            float projection = pixels[i][0] * axis[0] + pixels[i][1] * axis[1] + pixels[i][2] * axis[2];
+            if (projection < minProjection) { minProjection = projection; minIndex = i; }
+            if (projection > maxProjection) { maxProjection = projection; maxIndex = i; }
+        }
+        float high[3] = { float(pixels[maxIndex][0]), float(pixels[maxIndex][1]), float(pixels[maxIndex][2]) };
+        float low[3] = { float(pixels[minIndex][0]), float(pixels[minIndex][1]), float(pixels[minIndex][2]) };
+        uint16_t color0 = to565(high), color1 = to565(low);
+        // color0 > color1 selects the four colour mode
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        int palette[4][3];
+        from565(color0, palette[0]);
+        from565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            for (int i = 0; i < 16; ++i) {
+                int best = 0, bestDistance = 1 << 30;
+                for (int p = 0; p < 4; ++p) {
+                    int dr = pixels[i][0] - palette[p][0], dg = pixels[i][1] - palette[p][1], db = pixels[i][2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance) { bestDistance = distance; best = p; }
+                }
+                indices |= uint32_t(best) << (i * 2);
+            }
+        }
+        out[0] = static_cast<unsigned char>(color0 & 0xff); out[1] = static_cast<unsigned char>(color0 >> 8);
+        out[2] = static_cast<unsigned char>(color1 & 0xff); out[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+
+    // BC3 alpha block: the lowest and highest alpha with six steps in between
+    void encodeAlphaBlock(const unsigned char pixels[16][4], unsigned char* out) {
+        int alpha0 = 0, alpha1 = 255;
+        for (int i = 0; i < 16; ++i) {
+            alpha0 = std::max(alpha0, int(pixels[i][3]));
+            alpha1 = std::min(alpha1, int(pixels[i][3]));
+        }
+        int palette[8] = { alpha0, alpha1 };
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1) {
+            for (int i = 0; i < 16; ++i) {
+                int best = 0;
+                for (int p = 1; p < 8; ++p) {
+                    if (std::abs(pixels[i][3] - palette[p]) < std::abs(pixels[i][3] - palette[best]))
+                        best = p;
+                }
+                indices |= uint64_t(best) << (i * 3);
+            }
+        }
+        out[0] = static_cast<unsigned char>(alpha0);
+        out[1] = static_cast<unsigned char>(alpha1);
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+
+    std::vector<unsigned char> compress(const std::vector<unsigned char>& rgba, uint32_t width, uint32_t height, bool alpha) {
+        uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t bytes = alpha ? 16 : 8;
+        std::vector<unsigned char> result(size_t(blocksX) * blocksY * bytes);
+        for (uint32_t by = 0; by < blocksY; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                // the pixels outside a small level repeat the last row and column
+                unsigned char pixels[16][4];
+                for (uint32_t i = 0; i < 16; ++i) {
+                    uint32_t x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                    std::memcpy(pixels[i], &rgba[(size_t(y) * width + x) * 4], 4);
+                }
+                unsigned char* out = &result[(size_t(by) * blocksX + bx) * bytes];
+                if (alpha) {
+                    encodeAlphaBlock(pixels, out);
+                    out += 8;
+                }
+                encodeColorBlock(pixels, out);
+            }
+        }
+        return result;
+    }
+}
+
+TextureFileData TextureFile::Build(const unsigned char* rgba, int width, int height, bool bottomUp, bool compressData) {
+    TextureFileData data;
+    data.bottomUp = bottomUp;
+    data.compressed = compressData;
+
+    bool opaque = true;
+    for (size_t i = 0; i < size_t(width) * height; ++i)
+        opaque = opaque && rgba[i * 4 + 3] == 255;
+    data.glInternalFormat = !compressData ? KTX_GL_RGBA8 : opaque ? KTX_GL_COMPRESSED_RGB_S3TC_DXT1 : KTX_GL_COMPRESSED_RGBA_S3TC_DXT5;
+
+    // the full chain down to 1x1
+    std::vector<unsigned char> level(rgba, rgba + size_t(width) * height * 4);
+    uint32_t levelWidth = width, levelHeight = height;
+    for (;;) {
+        data.widths.push_back(levelWidth);
+        data.heights.push_back(levelHeight);
+        data.levels.push_back(compressData ? compress(level, levelWidth, levelHeight, !opaque) : level);
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+
+        uint32_t nextWidth = std::max(levelWidth / 2, 1u), nextHeight = std::max(levelHeight / 2, 1u);
+        level = downsample(level, levelWidth, levelHeight, nextWidth, nextHeight);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+    return data;
+}
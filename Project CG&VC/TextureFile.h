@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// One mip level, pointing into a mapped .ktx (or into a TextureFileData)
+struct TextureLevel {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	const unsigned char* data = nullptr;
+	uint32_t size = 0;
+};
+
+// A texture that can go to the GPU as is; the formats are the GL enums of the KTX header
+struct TextureFileView {
+	uint32_t glInternalFormat = 0;	// GL_RGBA8, or a BC1/BC3 (S3TC) format
+	uint32_t glFormat = 0;			// 0 for compressed data
+	uint32_t glType = 0;			// 0 for compressed data
+	bool compressed = false;
+	std::vector<TextureLevel> levels;	// level 0 first
+};
+
+// The mip chain of an image, made by the converter
+struct TextureFileData {
+	uint32_t glInternalFormat = 0;
+	bool compressed = false;
+	bool bottomUp = false;		// the rows in GL order, like stbi with flip
+	std::vector<uint32_t> widths;
+	std::vector<uint32_t> heights;
+	std::vector<std::vector<unsigned char>> levels;
+};
+
+/*
+* GPU-ready textures in KTX 1 files: every mip level, optionally block compressed (BC1/BC3)
+* containts:
+*		- the .ktx written next to the source image, mapped and uploaded without decoding when loading
+*		- the source hash (a key/value pair), so a baked texture is only used while its image hasn't changed
+*		- the row order (KTXorientation), a texture is only used for loads that flip like it was baked
+*		- building the mip chain (box filter in linear light) and the BC1/BC3 encoder for the converter
+*/
+class TextureFile {
+public:
+	static std::string BakedPath(const std::string& sourcePath) { return sourcePath + ".ktx"; }
+
+	// false when the file is missing, broken, made from another source or has the other row order; a sourceHash
+	// of 0 (no source file next to it) accepts any baked file
+	static bool Map(MappedFile& file, const std::string& path, uint64_t sourceHash, bool bottomUp, TextureFileView& view);
+
+	// throws std::runtime_error when the file can't be written
+	static void Save(const std::string& path, const TextureFileData& data, uint64_t sourceHash);
+
+	// 0 when the file doesn't exist
+	static uint64_t HashSource(const std::string& path);
+
+	// rgba: width * height RGBA8 pixels in the row order of bottomUp; BC1 for opaque images, BC3 with alpha
+	static TextureFileData Build(const unsigned char* rgba, int width, int height, bool bottomUp, bool compress);
+
+	static TextureFileView View(const TextureFileData& data);
+};
@@ -0,0 +1,129 @@
+#include "TrackBVH.h"
+
+#include <algorithm>
+#include <limits>
+
+void TrackBVH::Build(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax) {
+    m_boxMin = boxMin;
+    m_boxMax = boxMax;
+    m_nodes.clear();
+    m_chunkOrder.resize(boxMin.size());
+    for (size_t i = 0; i < m_chunkOrder.size(); ++i)
+        m_chunkOrder[i] = static_cast<int>(i);
+
+    if (!m_chunkOrder.empty()) {
+        m_nodes.reserve(2 * m_chunkOrder.size());
+        buildNode(0, static_cast<int>(m_chunkOrder.size()));
+    }
+}
+
+// Top down: the box of the node around all its chunks, then split at the median along the longest axis
+int TrackBVH::buildNode(int first, int count) {
+    int index = static_cast<int>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    Node node;
+    node.boxMin = m_boxMin[m_chunkOrder[first]];
+    node.boxMax = m_boxMax[m_chunkOrder[first]];
+    glm::vec3 centerMin = (node.boxMin + node.boxMax) * 0.5f;
+    glm::vec3 centerMax = centerMin;
+    for (int i = first; i < first + count; ++i) {
+        int chunk = m_chunkOrder[i];
+        node.boxMin = glm::min(node.boxMin, m_boxMin[chunk]);
+        node.boxMax = glm::max(node.boxMax, m_boxMax[chunk]);
+        glm::vec3 center = (m_boxMin[chunk] + m_boxMax[chunk]) * 0.5f;
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+
+    if (count <= MAX_LEAF_SIZE) {
+        node.first = first;
+        node.count = count;
+        m_nodes[index] = node;
+        return index;
+    }
+
+    glm::vec3 extent = centerMax - centerMin;
+    int axis = 0;
+    if (extent.y > extent.x) axis = 1;
+    if (extent.z > (axis == 0 ? extent.x : extent.y)) axis = 2;
+
+    int half = count / 2;
+    std::nth_element(m_chunkOrder.begin() + first, m_chunkOrder.begin() + first + half, m_chunkOrder.begin() + first + count,
+        [&](int a, int b) { return (m_boxMin[a][axis] + m_boxMax[a][axis]) < (m_boxMin[b][axis] + m_boxMax[b][axis]); });
+
+    // m_nodes can grow while the children are built, so the node is written at the end
+    node.left = buildNode(first, half);
+    node.right = buildNode(first + half, count - half);
+    m_nodes[index] = node;
+    return index;
+}
+
+void TrackBVH::CollectVisible(const Frustum& frustum, std::vector<int>& visible) const {
+    if (!m_nodes.empty())
+        collectNode(0, frustum, false, visible);
+}
+
+void TrackBVH::collectNode(int index, const Frustum& frustum, bool inside, std::vector<int>& visible) const {
+    const Node& node = m_nodes[index];
+    if (!inside) {
+        int result = frustum.TestBox(node.boxMin, node.boxMax);
+        if (result < 0)
+            return;
+        // everything below a node that is completely inside is visible as well
+        inside = result > 0;
+    }
+
+    if (node.left < 0) {
+        for (int i = node.first; i < node.first + node.count; ++i) {
+            int chunk = m_chunkOrder[i];
+            if (inside || frustum.TestBox(m_boxMin[chunk], m_boxMax[chunk]) >= 0)
+                visible.push_back(chunk);
+        }
+        return;
+    }
+    collectNode(node.left, frustum, inside, visible);
+    collectNode(node.right, frustum, inside, visible);
+}
+
+int TrackBVH::FindNearest(const glm::vec3& point, const std::function<float(int chunk, float best)>& exactDistance, float& distance) const {
+    distance = std::numeric_limits<float>::max();
+    int bestChunk = -1;
+    if (!m_nodes.empty())
+        nearestNode(0, point, exactDistance, distance, bestChunk);
+    return bestChunk;
+}
+
+void TrackBVH::nearestNode(int index, const glm::vec3& point, const std::function<float(int, float)>& exactDistance,
+    float& best, int& bestChunk) const {
+    const Node& node = m_nodes[index];
+    if (boxDistance(point, node.boxMin, node.boxMax) >= best)
+        return;
+
+    if (node.left < 0) {
+        for (int i = node.first; i < node.first + node.count; ++i) {
+            int chunk = m_chunkOrder[i];
+            if (boxDistance(point, m_boxMin[chunk], m_boxMax[chunk]) >= best)
+                continue;
+            float distance = exactDistance(chunk, best);
+            if (distance < best) {
+                best = distance;
+                bestChunk = chunk;
+            }
+        }
+        return;
+    }
+
+    // the closest child first, so the other one is more likely to be skipped
+    int nearChild = node.left, farChild = node.right;
+    if (boxDistance(point, m_nodes[farChild].boxMin, m_nodes[farChild].boxMax) < boxDistance(point, m_nodes[nearChild].boxMin, m_nodes[nearChild].boxMax))
+        std::swap(nearChild, farChild);
+    nearestNode(nearChild, point, exactDistance, best, bestChunk);
+    nearestNode(farChild, point, exactDistance, best, bestChunk);
+}
+
+// zero when the point lies inside the box
+float TrackBVH::boxDistance(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 closest = glm::clamp(point, boxMin, boxMax);
+    return glm::length(point - closest);
+}
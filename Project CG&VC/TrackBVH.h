@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+/*
+* Bounding volume hierarchy over the axis aligned boxes of the track chunks
+* containts:
+*		- a binary tree, split at the median chunk along the longest axis, leaves hold a few chunks
+*		- frustum culling: whole subtrees are skipped (outside) or accepted without further tests (inside)
+*		- nearest queries: subtrees are visited closest box first and skipped when they can't be closer
+*/
+class TrackBVH {
+public:
+	void Build(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax);
+
+	// appends the chunks whose box touches the frustum
+	void CollectVisible(const Frustum& frustum, std::vector<int>& visible) const;
+
+	// exactDistance(chunk, best) returns the distance from the point to the geometry of a chunk,
+	// it can stop early when nothing is closer than best. Returns the closest chunk or -1.
+	int FindNearest(const glm::vec3& point, const std::function<float(int chunk, float best)>& exactDistance, float& distance) const;
+
+	int GetNodeCount() const { return static_cast<int>(m_nodes.size()); }
+
+private:
+	struct Node {
+		glm::vec3 boxMin;
+		glm::vec3 boxMax;
+		int left = -1, right = -1;	// children, -1 for a leaf
+		int first = 0, count = 0;	// range in m_chunkOrder for a leaf
+	};
+
+	static const int MAX_LEAF_SIZE = 2;
+
+	std::vector<Node> m_nodes;
+	std::vector<int> m_chunkOrder;
+	std::vector<glm::vec3> m_boxMin, m_boxMax;
+
+	int buildNode(int first, int count);
+	void collectNode(int node, const Frustum& frustum, bool inside, std::vector<int>& visible) const;
+	void nearestNode(int node, const glm::vec3& point, const std::function<float(int, float)>& exactDistance,
+		float& best, int& bestChunk) const;
+	static float boxDistance(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax);
+};
@@ -0,0 +1,129 @@
+#include "TrackFile.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+static const uint32_t TRACK_FILE_VERSION = 1;
+
+static bool hasExtension(const std::string& path, const std::string& extension) {
+    return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+std::vector<std::vector<glm::vec3>> TrackFile::Load(const std::string& path) {
+    if (hasExtension(path, ".trackb"))
+        return LoadBinary(path);
+    return LoadText(path);
+}
+
+std::vector<std::vector<glm::vec3>> TrackFile::LoadText(const std::string& path) {
+    std::ifstream file(path);
+    if (!file)
+        throw std::runtime_error("TrackFile: can't open " + path);
+
+    std::vector<std::vector<glm::vec3>> segments;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        // strip comments
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream stream(line);
+        std::string word;
+        if (!(stream >> word))
+            continue;
+
+        if (word == "segment") {
+            if (!segments.empty() && segments.back().size() != 4)
+                throw std::runtime_error("TrackFile: " + path + ":" + std::to_string(lineNumber) + ": previous segment doesn't have 4 control points");
+            segments.emplace_back();
+            continue;
+        }
+
+        // a control point
+        stream.clear();
+        stream.str(line);
+        glm::vec3 point;
+        if (segments.empty() || !(stream >> point.x >> point.y >> point.z))
+            throw std::runtime_error("TrackFile: " + path + ":" + std::to_string(lineNumber) + ": expected \"segment\" or \"x y z\"");
+        segments.back().push_back(point);
+    }
+
+    if (segments.empty() || segments.back().size() != 4)
+        throw std::runtime_error("TrackFile: " + path + " doesn't contain complete segments");
+    return segments;
+}
+
+std::vector<std::vector<glm::vec3>> TrackFile::LoadBinary(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path))
+        throw std::runtime_error("TrackFile: can't open " + path);
+
+    TrackFileHeader header;
+    if (file.GetSize() < sizeof(header))
+        throw std::runtime_error("TrackFile: " + path + " is too small");
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (std::memcmp(header.magic, "TRKB", 4) != 0 || header.version != TRACK_FILE_VERSION)
+        throw std::runtime_error("TrackFile: " + path + " is not a version " + std::to_string(TRACK_FILE_VERSION) + " binary track");
+    if (header.segmentCount == 0 || file.GetSize() < sizeof(header) + header.segmentCount * 12 * sizeof(float))
+        throw std::runtime_error("TrackFile: " + path + " is truncated");
+
+    const unsigned char* data = file.GetData() + sizeof(header);
+    std::vector<std::vector<glm::vec3>> segments(header.segmentCount, std::vector<glm::vec3>(4));
+    for (auto& segment : segments) {
+        for (auto& point : segment) {
+            float xyz[3];
+            std::memcpy(xyz, data, sizeof(xyz));
+            point = glm::vec3(xyz[0], xyz[1], xyz[2]);
+            data += sizeof(xyz);
+        }
+    }
+    return segments;
+}
+
+void TrackFile::SaveText(const std::string& path, const std::vector<std::vector<glm::vec3>>& segments) {
+    std::ofstream file(path);
+    if (!file)
+        throw std::runtime_error("TrackFile: can't write " + path);
+
+    // enough digits to read back the same floats
+    file.precision(9);
+    file << "# Rollercoaster track, every segment is a cubic Bezier curve with 4 control points (x y z)\n";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        file << "segment " << i + 1 << "\n";
+        for (const auto& point : segments[i])
+            file << point.x << " " << point.y << " " << point.z << "\n";
+    }
+}
+
+void TrackFile::SaveBinary(const std::string& path, const std::vector<std::vector<glm::vec3>>& segments) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("TrackFile: can't write " + path);
+
+    TrackFileHeader header = { { 'T', 'R', 'K', 'B' }, TRACK_FILE_VERSION, static_cast<uint32_t>(segments.size()), 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& segment : segments) {
+        for (size_t i = 0; i < 4; ++i) {
+            float xyz[3] = { segment[i].x, segment[i].y, segment[i].z };
+            file.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+        }
+    }
+}
+
+// FNV-1a, 64 bit
+uint64_t TrackFile::Hash(const void* data, size_t size, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
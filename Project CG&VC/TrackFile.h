@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Header of a binary track (.trackb), followed by segmentCount * 4 control points (3 floats each)
+struct TrackFileHeader {
+	char magic[4];			// "TRKB"
+	uint32_t version;
+	uint32_t segmentCount;
+	uint32_t reserved;
+};
+
+// Header of a baked track mesh (.trackmesh), followed by the segment slots, the vertices
+// (position + color) and the indices, laid out exactly like the GPU buffers
+struct TrackMeshHeader {
+	char magic[4];			// "TMSH"
+	uint32_t version;
+	uint64_t hash;			// content hash of the control points and generation settings
+	uint32_t segmentCount;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t reserved;
+};
+
+/*
+* Loads and saves track definitions
+* containts:
+*		- a text format for authoring (.track): "segment <name>" followed by four "x y z" lines, # starts a comment
+*		- a compact binary format for shipping (.trackb), read through a memory mapped file
+*		- FNV-1a hashing, used to check if a baked track mesh still belongs to the track
+*/
+class TrackFile {
+public:
+	// picks the format from the extension, throws std::runtime_error when the file can't be read
+	static std::vector<std::vector<glm::vec3>> Load(const std::string& path);
+	static std::vector<std::vector<glm::vec3>> LoadText(const std::string& path);
+	static std::vector<std::vector<glm::vec3>> LoadBinary(const std::string& path);
+
+	static void SaveText(const std::string& path, const std::vector<std::vector<glm::vec3>>& segments);
+	static void SaveBinary(const std::string& path, const std::vector<std::vector<glm::vec3>>& segments);
+
+	static const uint64_t HashSeed = 14695981039346656037ull;
+	static uint64_t Hash(const void* data, size_t size, uint64_t hash = HashSeed);
+};
@@ -0,0 +1,243 @@
+#include "TrackSampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+TrackSampler::TrackSampler(int samplesPerCurve) : m_samplesPerCurve(samplesPerCurve) {
+}
+
+// Samples every curve once and fills the position/tangent/frame/arc length tables
+void TrackSampler::Build(const std::vector<BezierCurve>& curves) {
+    m_curveCount = static_cast<int>(curves.size());
+    m_samples.assign(curves.size() * (m_samplesPerCurve + 1), TrackSample());
+    if (m_samples.empty())
+        return;
+
+    for (int c = 0; c < m_curveCount; ++c)
+        buildCurve(curves[c], c);
+
+    updateDistances();
+
+    // start frame: right vector in the horizontal plane
+    TrackSample& first = m_samples[0];
+    glm::vec3 worldUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    if (glm::length(glm::cross(first.tangent, worldUp)) < 0.01f)
+        worldUp = glm::vec3(1.0f, 0.0f, 0.0f);
+    first.right = glm::normalize(glm::cross(worldUp, first.tangent));
+
+    // the frame travels over the whole closed track and has to end on the start frame again
+    std::vector<int> track(m_curveCount);
+    for (int c = 0; c < m_curveCount; ++c)
+        track[c] = c;
+    transportFrames(track, first.right);
+}
+
+// Only the edited curves are evaluated again. Every run of edited curves gets the frame from the end
+// of the untouched curve before it and is transported up to the untouched curve after it, so the
+// frames of the other curves stay the same.
+void TrackSampler::Rebuild(const std::vector<BezierCurve>& curves, const std::vector<int>& dirtyCurves) {
+    if (static_cast<int>(curves.size()) != m_curveCount) {
+        Build(curves);
+        return;
+    }
+
+    std::vector<bool> dirty(m_curveCount, false);
+    for (int c : dirtyCurves)
+        dirty[c] = true;
+
+    // without an untouched curve there is nothing to start from
+    int clean = static_cast<int>(std::find(dirty.begin(), dirty.end(), false) - dirty.begin());
+    if (clean == m_curveCount) {
+        Build(curves);
+        return;
+    }
+
+    for (int c : dirtyCurves)
+        buildCurve(curves[c], c);
+
+    updateDistances();
+
+    // walk once around the closed track, starting behind an untouched curve
+    std::vector<int> range;
+    for (int k = 1; k <= m_curveCount; ++k) {
+        int c = (clean + k) % m_curveCount;
+        if (dirty[c]) {
+            range.push_back(c);
+            continue;
+        }
+        if (range.empty())
+            continue;
+
+        int previous = (range.front() + m_curveCount - 1) % m_curveCount;
+        glm::vec3 right = GetSample(previous, m_samplesPerCurve).right;
+        TrackSample& start = m_samples[range.front() * (m_samplesPerCurve + 1)];
+        start.right = glm::normalize(right - start.tangent * glm::dot(right, start.tangent));
+
+        transportFrames(range, GetSample(c, 0).right);
+        range.clear();
+    }
+}
+
+// Evaluates the position and tangent of every sample of one curve, the frames are done by transportFrames
+void TrackSampler::buildCurve(const BezierCurve& curve, int index) {
+    // the same parameters are used for every curve
+    int count = m_samplesPerCurve + 1;
+    std::vector<float> parameters(count);
+    for (int i = 0; i < count; ++i)
+        parameters[i] = static_cast<float>(i) / m_samplesPerCurve;
+
+    std::vector<float> x(count), y(count), z(count), tx(count), ty(count), tz(count);
+    curve.EvaluateBatch(parameters.data(), count, x.data(), y.data(), z.data(), tx.data(), ty.data(), tz.data());
+
+    TrackSample* samples = &m_samples[index * count];
+    for (int i = 0; i < count; ++i) {
+        TrackSample& sample = samples[i];
+        sample.position = glm::vec3(x[i], y[i], z[i]);
+
+        glm::vec3 tangent = glm::vec3(tx[i], ty[i], tz[i]);
+        if (glm::length(tangent) < 0.0001f) {
+            int next = (i > 0) ? i : 1;
+            tangent = glm::vec3(x[next] - x[next - 1], y[next] - y[next - 1], z[next] - z[next - 1]);
+        }
+        sample.tangent = glm::normalize(tangent);
+    }
+}
+
+// Transports the frame of the first sample of the curves along all their samples with the double reflection
+// method (Wang et al. 2008), so the rails don't twist or flip on steep parts. The twist that is left at the
+// end compared to endRight is spread out evenly over the length of the curves.
+void TrackSampler::transportFrames(const std::vector<int>& curves, const glm::vec3& endRight) {
+    int count = m_samplesPerCurve + 1;
+    std::vector<TrackSample*> samples;
+    samples.reserve(curves.size() * count);
+    for (int c : curves) {
+        for (int i = 0; i < count; ++i)
+            samples.push_back(&m_samples[c * count + i]);
+    }
+
+    std::vector<float> length(samples.size(), 0.0f);
+    for (size_t i = 0; i + 1 < samples.size(); ++i) {
+        const TrackSample& current = *samples[i];
+        TrackSample& next = *samples[i + 1];
+
+        glm::vec3 v1 = next.position - current.position;
+        float c1 = glm::dot(v1, v1);
+        length[i + 1] = length[i] + sqrt(c1);
+        if (c1 < 1e-8f) {
+            // curve boundary, both samples sit on the same point
+            next.right = current.right - next.tangent * glm::dot(current.right, next.tangent);
+        }
+        else {
+            // reflect the frame in the plane between both points, then in the plane that maps the tangents onto each other
+            glm::vec3 reflectedRight = current.right - (2.0f / c1) * glm::dot(v1, current.right) * v1;
+            glm::vec3 reflectedTangent = current.tangent - (2.0f / c1) * glm::dot(v1, current.tangent) * v1;
+            glm::vec3 v2 = next.tangent - reflectedTangent;
+            float c2 = glm::dot(v2, v2);
+            next.right = c2 < 1e-8f ? reflectedRight : reflectedRight - (2.0f / c2) * glm::dot(v2, reflectedRight) * v2;
+        }
+        next.right = glm::normalize(next.right);
+    }
+
+    // how far the transported frame is turned around the tangent compared to the frame it has to end on
+    const TrackSample& last = *samples.back();
+    glm::vec3 target = glm::normalize(endRight - last.tangent * glm::dot(endRight, last.tangent));
+    float twist = atan2(glm::dot(glm::cross(last.right, target), last.tangent), glm::dot(last.right, target));
+    float totalLength = length.back();
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        TrackSample& sample = *samples[i];
+        float angle = totalLength > 0.0f ? twist * (length[i] / totalLength) : 0.0f;
+        // rotate around the tangent (right is perpendicular to it)
+        sample.right = glm::normalize(sample.right * cos(angle) + glm::cross(sample.tangent, sample.right) * sin(angle));
+        sample.up = glm::normalize(glm::cross(sample.tangent, sample.right));
+    }
+}
+
+// Cumulative distance over the whole track and the arc length table, O(samples)
+void TrackSampler::updateDistances() {
+    m_arcLengthTable.clear();
+    m_arcLengthTable.reserve(m_curveCount * m_samplesPerCurve + 1);
+
+    int count = m_samplesPerCurve + 1;
+    float distance = 0.0f;
+    for (int c = 0; c < m_curveCount; ++c) {
+        for (int i = 0; i < count; ++i) {
+            TrackSample& sample = m_samples[c * count + i];
+
+            // the end of a curve is the start of the next one, so only add the length within a curve
+            if (i > 0)
+                distance += glm::length(sample.position - m_samples[c * count + i - 1].position);
+            sample.distance = distance;
+
+            // the start of a curve has the same length as the end of the previous curve, store it only once
+            if (i > 0 || m_arcLengthTable.empty()) {
+                float t = static_cast<float>(c) + static_cast<float>(i) / m_samplesPerCurve;
+                m_arcLengthTable.push_back({ t, distance });
+            }
+        }
+    }
+}
+
+// Linear interpolation between the two samples around t
+TrackSample TrackSampler::SampleAt(int curve, float t) const {
+    float f = glm::clamp(t, 0.0f, 1.0f) * m_samplesPerCurve;
+    int index = static_cast<int>(f);
+    if (index >= m_samplesPerCurve)
+        index = m_samplesPerCurve - 1;
+    float fraction = f - index;
+
+    const TrackSample& a = GetSample(curve, index);
+    const TrackSample& b = GetSample(curve, index + 1);
+
+    TrackSample result;
+    result.position = glm::mix(a.position, b.position, fraction);
+    result.tangent = glm::normalize(glm::mix(a.tangent, b.tangent, fraction));
+    // keep the interpolated frame orthonormal
+    glm::vec3 right = glm::mix(a.right, b.right, fraction);
+    result.right = glm::normalize(right - result.tangent * glm::dot(right, result.tangent));
+    result.up = glm::cross(result.tangent, result.right);
+    result.distance = glm::mix(a.distance, b.distance, fraction);
+    return result;
+}
+
+// Finds the curve and local t that lie at the given arc length
+TrackLocation TrackSampler::LocateDistance(float distance) const {
+    if (m_arcLengthTable.size() < 2)
+        return { 0, 0.0f };
+
+    distance = WrapDistance(distance);
+
+    // first entry with a length greater than the distance
+    auto upper = std::upper_bound(m_arcLengthTable.begin() + 1, m_arcLengthTable.end(), distance,
+        [](float value, const ArcLengthEntry& entry) { return value < entry.length; });
+    if (upper == m_arcLengthTable.end())
+        upper = m_arcLengthTable.end() - 1;
+    auto lower = upper - 1;
+
+    float span = upper->length - lower->length;
+    float fraction = span > 0.0f ? (distance - lower->length) / span : 0.0f;
+    float t = glm::mix(lower->t, upper->t, fraction);
+
+    int curve = std::min(static_cast<int>(t), m_curveCount - 1);
+    return { curve, t - curve };
+}
+
+TrackSample TrackSampler::SampleAtDistance(float distance) const {
+    TrackLocation location = LocateDistance(distance);
+    return SampleAt(location.curve, location.t);
+}
+
+// Keeps a distance within [0, total length) so the remainder carries over to the next lap
+float TrackSampler::WrapDistance(float distance) const {
+    float total = GetTotalLength();
+    if (total <= 0.0f)
+        return 0.0f;
+    distance = std::fmod(distance, total);
+    if (distance < 0.0f)
+        distance += total;
+    return distance;
+}
+
+float TrackSampler::GetCurveLength(int curve) const {
+    return GetSample(curve, m_samplesPerCurve).distance - GetSample(curve, 0).distance;
+}
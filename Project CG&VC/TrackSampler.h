@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "BezierCurve.h"
+
+// One baked point on the track
+struct TrackSample {
+	glm::vec3 position;
+	glm::vec3 tangent;	// unit length
+	glm::vec3 right;	// unit length, points to the right rail
+	glm::vec3 up;		// unit length
+	float distance;		// arc length from the start of the track
+};
+
+// A point on the track expressed as curve index + local parameter
+struct TrackLocation {
+	int curve;
+	float t;
+};
+
+/*
+* This class caches the sampled track so the curves are only tessellated once per track edit
+* containts:
+*		- a table with position, tangent, frame and arc length for every sample
+*		- the frames are rotation minimising (parallel transport), so they don't flip on steep parts
+*		- after an edit the frames are only transported again over the edited curves, between the frames of their untouched neighbours
+*		- every curve owns (samplesPerCurve + 1) samples, the first and last sample sit on t = 0 and t = 1
+*		- an arc length table over the whole closed track (t = curve index + local t) for distance -> (curve, t) lookups
+*/
+class TrackSampler {
+public:
+	TrackSampler(int samplesPerCurve = 100);
+
+	// (re)builds all tables, call this after the track has been edited
+	void Build(const std::vector<BezierCurve>& curves);
+	// resamples only the edited curves, the distances of the whole track are updated afterwards
+	void Rebuild(const std::vector<BezierCurve>& curves, const std::vector<int>& dirtyCurves);
+
+	// interpolated sample at parameter t of a curve
+	TrackSample SampleAt(int curve, float t) const;
+
+	// binary search in the arc length table, the distance is wrapped around the closed track
+	TrackLocation LocateDistance(float distance) const;
+	TrackSample SampleAtDistance(float distance) const;
+	float WrapDistance(float distance) const;
+
+	const std::vector<TrackSample>& GetSamples() const { return m_samples; }
+	const TrackSample& GetSample(int curve, int index) const { return m_samples[curve * (m_samplesPerCurve + 1) + index]; }
+
+	int GetCurveCount() const { return m_curveCount; }
+	int GetSamplesPerCurve() const { return m_samplesPerCurve; }
+	float GetCurveLength(int curve) const;
+	float GetTotalLength() const { return m_samples.empty() ? 0.0f : m_samples.back().distance; }
+
+private:
+	int m_samplesPerCurve;
+	int m_curveCount = 0;
+	std::vector<TrackSample> m_samples;
+	std::vector<ArcLengthEntry> m_arcLengthTable;
+
+	void buildCurve(const BezierCurve& curve, int index);
+	void updateDistances();
+	void transportFrames(const std::vector<int>& curves, const glm::vec3& endRight);
+};
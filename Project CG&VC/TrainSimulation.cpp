@@ -0,0 +1,141 @@
+#include "TrainSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRAIN_SSE
+#endif
+
+// all trains start again, evenly spread and at chain speed
+void TrainSimulation::SetTrainCount(int count) {
+    count = std::max(count, 0);
+    m_distance.resize(count);
+    m_velocity.assign(count, m_physics.chainSpeed);
+    for (int i = 0; i < count; ++i)
+        m_distance[i] = m_trackLength * i / count;
+    m_previousDistance = m_distance;
+}
+
+void TrainSimulation::Rebuild(const TrackSampler& sampler) {
+    // trains keep their fraction of the track, so the spacing between them survives an edit
+    float oldLength = m_trackLength;
+    m_trackLength = sampler.GetTotalLength();
+    if (oldLength > 0.0f && oldLength != m_trackLength) {
+        float scale = m_trackLength / oldLength;
+        for (size_t i = 0; i < m_distance.size(); ++i) {
+            m_distance[i] = sampler.WrapDistance(m_distance[i] * scale);
+            m_previousDistance[i] = sampler.WrapDistance(m_previousDistance[i] * scale);
+        }
+    }
+    size_t count = static_cast<size_t>(std::ceil(m_trackLength / m_slopeSpacing)) + 1;
+
+    m_slope.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        m_slope[i] = sampler.SampleAtDistance(i * m_slopeSpacing).tangent.y;
+
+    m_physics.PlaceChainOnFirstClimb(sampler);
+}
+
+float TrainSimulation::SlopeAt(float distance) const {
+    const int lastSlope = static_cast<int>(m_slope.size()) - 1;
+    float position = distance / m_slopeSpacing;
+    int index = std::min(static_cast<int>(position), lastSlope);
+    float next = m_slope[std::min(index + 1, lastSlope)];
+    return m_slope[index] + (position - index) * (next - m_slope[index]);
+}
+
+// the same equations as CartPhysics::Step
+void TrainSimulation::SimulateRange(size_t begin, size_t end, int steps) {
+    const float dt = CartPhysics::TIMESTEP;
+    const float gravity = m_physics.gravity;
+    const float friction = m_physics.rollingFriction * m_physics.gravity;
+    const float drag = m_physics.dragArea / m_physics.mass;
+    const float total = m_trackLength;
+    const float inverseSpacing = 1.0f / m_slopeSpacing;
+    const float chainStart = m_physics.chainStart, chainEnd = m_physics.chainEnd, chainSpeed = m_physics.chainSpeed;
+    const int lastSlope = static_cast<int>(m_slope.size()) - 1;
+
+    float* distance = m_distance.data();
+    float* velocity = m_velocity.data();
+
+    for (int step = 0; step < steps; ++step) {
+        // interpolation for rendering happens between the last two steps
+        if (step == steps - 1)
+            std::copy(m_distance.begin() + begin, m_distance.begin() + end, m_previousDistance.begin() + begin);
+
+        size_t i = begin;
+#if defined(TRAIN_SSE)
+        const __m128 vDt = _mm_set1_ps(dt);
+        const __m128 vGravity = _mm_set1_ps(-gravity);
+        const __m128 vFriction = _mm_set1_ps(friction);
+        const __m128 vDrag = _mm_set1_ps(drag);
+        const __m128 vTotal = _mm_set1_ps(total);
+        const __m128 vInverseSpacing = _mm_set1_ps(inverseSpacing);
+        const __m128 vChainStart = _mm_set1_ps(chainStart);
+        const __m128 vChainEnd = _mm_set1_ps(chainEnd);
+        const __m128 vChainSpeed = _mm_set1_ps(chainSpeed);
+        const __m128 vZero = _mm_setzero_ps();
+        const __m128 vOne = _mm_set1_ps(1.0f);
+        const __m128 vSign = _mm_set1_ps(-0.0f);
+
+        for (; i + 4 <= end; i += 4) {
+            __m128 d = _mm_loadu_ps(distance + i);
+            __m128 v = _mm_loadu_ps(velocity + i);
+
+            // slope lookup, the only part that isn't 4 wide, then the interpolation between the two entries
+            __m128 position = _mm_mul_ps(d, vInverseSpacing);
+            __m128i whole = _mm_cvttps_epi32(position);
+            __m128 fraction = _mm_sub_ps(position, _mm_cvtepi32_ps(whole));
+            alignas(16) int index[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(index), whole);
+            __m128 slope0 = _mm_setr_ps(m_slope[std::min(index[0], lastSlope)], m_slope[std::min(index[1], lastSlope)],
+                m_slope[std::min(index[2], lastSlope)], m_slope[std::min(index[3], lastSlope)]);
+            __m128 slope1 = _mm_setr_ps(m_slope[std::min(index[0] + 1, lastSlope)], m_slope[std::min(index[1] + 1, lastSlope)],
+                m_slope[std::min(index[2] + 1, lastSlope)], m_slope[std::min(index[3] + 1, lastSlope)]);
+            __m128 slope = _mm_add_ps(slope0, _mm_mul_ps(fraction, _mm_sub_ps(slope1, slope0)));
+
+            // gravity along the track, friction and drag against the motion (nothing when standing still)
+            __m128 a = _mm_mul_ps(vGravity, slope);
+            __m128 direction = _mm_or_ps(_mm_and_ps(v, vSign), vOne);
+            __m128 resistance = _mm_mul_ps(direction, _mm_add_ps(vFriction, _mm_mul_ps(vDrag, _mm_mul_ps(v, v))));
+            a = _mm_sub_ps(a, _mm_and_ps(_mm_cmpneq_ps(v, vZero), resistance));
+            v = _mm_add_ps(v, _mm_mul_ps(a, vDt));
+
+            // lift hill chain
+            __m128 onChain = _mm_and_ps(_mm_cmpge_ps(d, vChainStart), _mm_cmplt_ps(d, vChainEnd));
+            v = _mm_or_ps(_mm_and_ps(onChain, _mm_max_ps(v, vChainSpeed)), _mm_andnot_ps(onChain, v));
+
+            // move and wrap around the closed track
+            d = _mm_add_ps(d, _mm_mul_ps(v, vDt));
+            d = _mm_sub_ps(d, _mm_and_ps(_mm_cmpge_ps(d, vTotal), vTotal));
+            d = _mm_add_ps(d, _mm_and_ps(_mm_cmplt_ps(d, vZero), vTotal));
+
+            _mm_storeu_ps(distance + i, d);
+            _mm_storeu_ps(velocity + i, v);
+        }
+#endif
+
+        // scalar fallback and remainder
+        for (; i < end; ++i) {
+            float d = distance[i];
+            float v = velocity[i];
+
+            float a = -gravity * SlopeAt(d);
+            if (v != 0.0f)
+                a -= (v > 0.0f ? 1.0f : -1.0f) * (friction + drag * v * v);
+            v += a * dt;
+
+            if (d >= chainStart && d < chainEnd)
+                v = std::max(v, chainSpeed);
+
+            d += v * dt;
+            if (d >= total) d -= total;
+            if (d < 0.0f) d += total;
+
+            distance[i] = d;
+            velocity[i] = v;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "CartPhysics.h"
+#include "TrackSampler.h"
+
+/*
+* The physics of many trains on one track, the same equations as CartPhysics, without OpenGL so the tests can run it
+* containts:
+*		- structure of arrays: distance, previous distance and velocity of every train in their own array
+*		- one pass over all trains per fixed step, 4 trains at a time with SSE; the slope is interpolated in
+*		  a table over the arc length instead of a binary search in the track tables
+*		- ranges of trains can be stepped on their own, trains don't interact
+*/
+class TrainSimulation {
+public:
+	// new trains are spread evenly over the track, at chain speed
+	void SetTrainCount(int count);
+	int GetTrainCount() const { return static_cast<int>(m_distance.size()); }
+
+	// the slope table and the chain of the track, again after every track edit; trains keep their fraction of the old length
+	void Rebuild(const TrackSampler& sampler);
+
+	// runs all steps for the trains in [begin, end), the previous distances are the ones before the last step
+	void SimulateRange(size_t begin, size_t end, int steps);
+
+	float GetDistance(size_t train) const { return m_distance[train]; }
+	float GetPreviousDistance(size_t train) const { return m_previousDistance[train]; }
+	float GetVelocity(size_t train) const { return m_velocity[train]; }
+	const CartPhysics& GetPhysics() const { return m_physics; }
+
+	// tangent.y at a distance, interpolated between the two table entries around it
+	float SlopeAt(float distance) const;
+
+private:
+	CartPhysics m_physics;
+	float m_trackLength = 0.0f;
+
+	// per train
+	std::vector<float> m_distance;
+	std::vector<float> m_previousDistance;
+	std::vector<float> m_velocity;
+
+	// tangent.y every m_slopeSpacing along the track
+	std::vector<float> m_slope;
+	float m_slopeSpacing = 0.25f;
+};
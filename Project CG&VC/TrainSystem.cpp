@@ -0,0 +1,179 @@
+#include "TrainSystem.h"
+#include "Cart.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+TrainSystem::TrainSystem(RollerCoaster* coaster, int carsPerTrain)
+    : m_rollerCoaster(coaster), m_carsPerTrain(std::max(carsPerTrain, 1)),
+    m_shader(".\\CartInstancedShader.vert", ".\\CartShader.frag"),
+    m_frontModel(".\\models\\cart\\coaster-train-front.fbx"), m_wagonModel(".\\models\\cart\\coaster-train.fbx") {
+
+    RebuildSlopeTable();
+
+    m_shader.bindUniformBlock("Lights", LightUniformBuffer::BINDING_POINT);
+
+    glGenBuffers(1, &m_frontInstanceVBO);
+    glGenBuffers(1, &m_wagonInstanceVBO);
+}
+
+TrainSystem::~TrainSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_rangesReady.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+
+    glDeleteBuffers(1, &m_frontInstanceVBO);
+    glDeleteBuffers(1, &m_wagonInstanceVBO);
+}
+
+// all trains start again, evenly spread and at chain speed
+void TrainSystem::SetTrainCount(int count) {
+    count = std::max(count, 0);
+    m_simulation.SetTrainCount(count);
+    m_curve.assign(count, 0);
+    m_t.assign(count, 0.0f);
+    m_accumulator = 0.0f;
+
+    m_frontMatrices.resize(count);
+    m_wagonMatrices.resize(static_cast<size_t>(count) * (m_carsPerTrain - 1));
+    prepareRange(0, count, 0.0f);
+}
+
+int TrainSystem::GetThreadCount() const {
+    if (m_threadCount > 0)
+        return m_threadCount;
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void TrainSystem::RebuildSlopeTable() {
+    m_simulation.Rebuild(m_rollerCoaster->getSampler());
+}
+
+void TrainSystem::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_rangesReady.wait(lock, [this] { return m_stopping || m_nextRange < m_ranges.size(); });
+        if (m_stopping)
+            return;
+        runNextRange(lock);
+    }
+}
+
+// takes the next range of the current split and runs it without holding the lock
+void TrainSystem::runNextRange(std::unique_lock<std::mutex>& lock) {
+    std::pair<size_t, size_t> range = m_ranges[m_nextRange++];
+    lock.unlock();
+    (*m_work)(range.first, range.second);
+    lock.lock();
+    if (--m_unfinishedRanges == 0)
+        m_rangesDone.notify_all();
+}
+
+// splits the trains in one range per thread, the calling thread runs ranges too until all of them are taken
+// minPerThread: waking a worker costs more than running a few hundred trains
+void TrainSystem::forEachRange(size_t minPerThread, const std::function<void(size_t, size_t)>& work) {
+    size_t count = m_simulation.GetTrainCount();
+    size_t threads = std::min(static_cast<size_t>(GetThreadCount()), (count + minPerThread - 1) / minPerThread);
+    if (threads <= 1) {
+        work(0, count);
+        return;
+    }
+
+    // one thread is the calling one
+    if (m_workers.empty()) {
+        unsigned int workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        for (unsigned int i = 0; i < workers; ++i)
+            m_workers.emplace_back(&TrainSystem::workerLoop, this);
+    }
+
+    // multiples of 4 so every range starts at a full SSE group
+    size_t perThread = ((count + threads - 1) / threads + 3) & ~static_cast<size_t>(3);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_work = &work;
+    for (size_t begin = 0; begin < count; begin += perThread)
+        m_ranges.push_back(std::make_pair(begin, std::min(begin + perThread, count)));
+    m_nextRange = 0;
+    m_unfinishedRanges = m_ranges.size();
+    m_rangesReady.notify_all();
+
+    while (m_nextRange < m_ranges.size())
+        runNextRange(lock);
+    m_rangesDone.wait(lock, [this] { return m_unfinishedRanges == 0; });
+    m_ranges.clear();
+    m_nextRange = 0;
+    m_work = nullptr;
+}
+
+void TrainSystem::Update(float deltaTime) {
+    if (m_simulation.GetTrainCount() == 0)
+        return;
+
+    m_accumulator += std::min(deltaTime, m_maxFrameTime);
+    int steps = static_cast<int>(m_accumulator / CartPhysics::TIMESTEP);
+    m_accumulator -= steps * CartPhysics::TIMESTEP;
+    float alpha = m_accumulator / CartPhysics::TIMESTEP;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (steps > 0)
+        forEachRange(4096, [this, steps](size_t begin, size_t end) { m_simulation.SimulateRange(begin, end, steps); });
+    auto simulated = std::chrono::high_resolution_clock::now();
+    forEachRange(128, [this, alpha](size_t begin, size_t end) { prepareRange(begin, end, alpha); });
+    auto prepared = std::chrono::high_resolution_clock::now();
+
+    m_stats.trains = GetTrainCount();
+    m_stats.steps = steps;
+    m_stats.simulateMs = std::chrono::duration<double, std::milli>(simulated - start).count();
+    m_stats.prepareMs = std::chrono::duration<double, std::milli>(prepared - simulated).count();
+}
+
+// interpolated position, curve and t of every train and the matrices of all its cars
+void TrainSystem::prepareRange(size_t begin, size_t end, float alpha) {
+    const TrackSampler& sampler = m_rollerCoaster->getSampler();
+    const float heightOffset = 0.60f;
+    size_t wagons = m_carsPerTrain - 1;
+
+    for (size_t i = begin; i < end; ++i) {
+        float distance = CartPhysics::Interpolate(sampler, m_simulation.GetPreviousDistance(i), m_simulation.GetDistance(i), alpha);
+        TrackLocation location = sampler.LocateDistance(distance);
+        m_curve[i] = location.curve;
+        m_t[i] = location.t;
+
+        TrackSample sample = sampler.SampleAt(location.curve, location.t);
+        m_frontMatrices[i] = Cart::CarMatrix(sample.position + sample.up * heightOffset, sample.tangent, sample.right, sample.up);
+
+        for (size_t car = 0; car < wagons; ++car) {
+            sample = sampler.SampleAtDistance(distance - (car + 1) * m_carSpacing);
+            m_wagonMatrices[i * wagons + car] = Cart::CarMatrix(sample.position + sample.up * heightOffset, sample.tangent, sample.right, sample.up);
+        }
+    }
+}
+
+void TrainSystem::Render(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& cameraPos) {
+    if (m_simulation.GetTrainCount() == 0)
+        return;
+
+    // grow the instance buffers when trains were added, otherwise orphan and refill them
+    size_t capacity = std::max(m_instanceCapacity, static_cast<size_t>(m_simulation.GetTrainCount()));
+    glBindBuffer(GL_ARRAY_BUFFER, m_frontInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_frontMatrices.size() * sizeof(glm::mat4), m_frontMatrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, m_wagonInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * (m_carsPerTrain - 1) * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    if (!m_wagonMatrices.empty())
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_wagonMatrices.size() * sizeof(glm::mat4), m_wagonMatrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_instanceCapacity = capacity;
+
+    m_shader.use();
+    m_shader.setMat4("projection", projection);
+    m_shader.setMat4("view", view);
+    m_shader.setVec3("viewPos", cameraPos);
+
+    m_frontModel.DrawInstanced(m_shader, m_frontInstanceVBO, static_cast<int>(m_frontMatrices.size()));
+    m_wagonModel.DrawInstanced(m_shader, m_wagonInstanceVBO, static_cast<int>(m_wagonMatrices.size()));
+}
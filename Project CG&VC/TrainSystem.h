@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "LightUniformBuffer.h"
+#include "Model.h"
+#include "RollerCoaster.h"
+#include "Shader.h"
+#include "TrainSimulation.h"
+
+// Timings of the last Update call
+struct TrainSystemStats {
+	int trains = 0;
+	int steps = 0;				// fixed steps in the last update
+	double simulateMs = 0.0;	// physics of all trains
+	double prepareMs = 0.0;		// curve lookup and car matrices
+};
+
+/*
+* Many trains on one track for stress tests, the physics (TrainSimulation) is the same as CartPhysics
+* containts:
+*		- the fixed timestep loop and the curve and t of every train, the steps themselves are in TrainSimulation
+*		- trains don't interact, so the trains are split over a pool of workers that live as long as the system
+*		  (every worker runs all steps of its trains)
+*		- one front car model and one wagon model shared by all trains, drawn with two instanced draws
+*/
+class TrainSystem {
+public:
+	TrainSystem(RollerCoaster* coaster, int carsPerTrain);
+	~TrainSystem();
+
+	TrainSystem(const TrainSystem&) = delete;
+	TrainSystem& operator=(const TrainSystem&) = delete;
+
+	// new trains are spread evenly over the track
+	void SetTrainCount(int count);
+	int GetTrainCount() const { return m_simulation.GetTrainCount(); }
+
+	// 0 uses every hardware thread
+	void SetThreadCount(int threads) { m_threadCount = threads; }
+	int GetThreadCount() const;
+
+	// the table has to be rebuilt when the track changes
+	void RebuildSlopeTable();
+
+	void Update(float deltaTime);
+	void Render(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& cameraPos);
+
+	const TrainSystemStats& GetStats() const { return m_stats; }
+
+private:
+	RollerCoaster* m_rollerCoaster;
+	TrainSimulation m_simulation;
+	int m_carsPerTrain;
+	float m_carSpacing = 7.0f;
+	int m_threadCount = 0;
+
+	// per train, where it is drawn
+	std::vector<int> m_curve;
+	std::vector<float> m_t;
+
+	float m_accumulator = 0.0f;
+	float m_maxFrameTime = 0.25f;
+
+	Shader m_shader;
+	Model m_frontModel;
+	Model m_wagonModel;
+	unsigned int m_frontInstanceVBO = 0, m_wagonInstanceVBO = 0;
+	size_t m_instanceCapacity = 0;
+	std::vector<glm::mat4> m_frontMatrices;
+	std::vector<glm::mat4> m_wagonMatrices;
+
+	TrainSystemStats m_stats;
+
+	// the workers of forEachRange, started by the first split; they take the ranges of m_work one at a time
+	std::mutex m_mutex;
+	std::condition_variable m_rangesReady;
+	std::condition_variable m_rangesDone;
+	std::vector<std::thread> m_workers;
+	bool m_stopping = false;
+	const std::function<void(size_t, size_t)>* m_work = nullptr;
+	std::vector<std::pair<size_t, size_t>> m_ranges;
+	size_t m_nextRange = 0;
+	size_t m_unfinishedRanges = 0;
+
+	void workerLoop();
+	void runNextRange(std::unique_lock<std::mutex>& lock);
+	void forEachRange(size_t minPerThread, const std::function<void(size_t, size_t)>& work);
+	void prepareRange(size_t begin, size_t end, float alpha);
+};
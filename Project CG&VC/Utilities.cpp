@@ -1,39 +1,6 @@
 #include "Utilities.h"
 
-// This method loads the texture from the given path
-unsigned int Utilities::loadTexture(std::string path) {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-
-	stbi_set_flip_vertically_on_load(false);
-
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-	if (data) {
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else {
-		std::cout << "Failed to load texture: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
+// This method loads the texture from the given path, every path is loaded once (TextureCache)
+std::shared_ptr<TextureResource> Utilities::loadTexture(const std::string& path) {
+	return TextureCache::Get(path, TextureSettings::Terrain());
 }
\ No newline at end of file
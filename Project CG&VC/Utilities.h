@@ -6,8 +6,11 @@
 #include "stb_image.h"
 
 #include <iostream>
+#include <memory>
+
+#include "TextureCache.h"
 
 class Utilities {
 public:
-	static unsigned int loadTexture(const std::string path);
+	static std::shared_ptr<TextureResource> loadTexture(const std::string& path);
 };
\ No newline at end of file
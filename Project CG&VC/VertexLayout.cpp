@@ -0,0 +1,34 @@
+#include "VertexLayout.h"
+#include "Shader.h"
+
+#include <glad/glad.h>
+
+namespace {
+    struct VertexAttribute {
+        GLuint location;
+        GLint size;
+        GLenum type;
+        size_t offset;
+    };
+
+    // all of them normalized, the shaders see [0, 1] for the unsigned and [-1, 1] for the signed ones
+    const VertexAttribute ATTRIBUTES[] = {
+        { 0, 3, GL_UNSIGNED_SHORT, offsetof(PackedVertex, position) },
+        { 1, 2, GL_SHORT, offsetof(PackedVertex, normal) },
+        { 2, 2, GL_UNSIGNED_SHORT, offsetof(PackedVertex, uv) },
+    };
+}
+
+void VertexLayout::Apply() {
+    for (const VertexAttribute& attribute : ATTRIBUTES) {
+        glVertexAttribPointer(attribute.location, attribute.size, attribute.type, GL_TRUE, sizeof(PackedVertex), (void*)attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
+
+void VertexLayout::SetUniforms(const Shader& shader, const VertexQuantization& quantization) {
+    shader.setVec3("positionOffset", glm::vec3(quantization.positionOffset[0], quantization.positionOffset[1], quantization.positionOffset[2]));
+    shader.setVec3("positionScale", glm::vec3(quantization.positionScale[0], quantization.positionScale[1], quantization.positionScale[2]));
+    shader.setVec2("uvOffset", glm::vec2(quantization.uvOffset[0], quantization.uvOffset[1]));
+    shader.setVec2("uvScale", glm::vec2(quantization.uvScale[0], quantization.uvScale[1]));
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "VertexPacking.h"
+
+class Shader;
+
+/*
+* The vertex format of models and the terrain on the GPU, the vertices are packed by VertexPacking
+* containts:
+*		- the attribute table (location 0: position, 1: normal, 2: uv), set up by Apply for the bound VAO and buffer
+*		- the decode uniforms (positionOffset, positionScale, uvOffset, uvScale) of the shaders that draw them
+*/
+class VertexLayout {
+public:
+	static void Apply();
+	static void SetUniforms(const Shader& shader, const VertexQuantization& quantization);
+};
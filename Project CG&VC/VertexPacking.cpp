@@ -0,0 +1,85 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex is uploaded as is");
+static_assert(sizeof(VertexQuantization) == 40, "VertexQuantization is written as is");
+
+namespace {
+    uint16_t quantizeUnorm(float value, float offset, float scale) {
+        float normalized = scale > 0.0f ? (value - offset) / scale : 0.0f;
+        return static_cast<uint16_t>(std::lround(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    int16_t quantizeSnorm(float value) {
+        return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+}
+
+VertexQuantization VertexPacking::Pack(const float* vertices, size_t vertexCount, size_t stride,
+    size_t positionOffset, size_t normalOffset, size_t uvOffset, std::vector<PackedVertex>& packed) {
+    VertexQuantization quantization;
+    packed.resize(vertexCount);
+    if (vertexCount == 0)
+        return quantization;
+
+    glm::vec3 minPosition(vertices[positionOffset], vertices[positionOffset + 1], vertices[positionOffset + 2]), maxPosition = minPosition;
+    glm::vec2 minUV(vertices[uvOffset], vertices[uvOffset + 1]), maxUV = minUV;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* vertex = vertices + i * stride;
+        glm::vec3 position(vertex[positionOffset], vertex[positionOffset + 1], vertex[positionOffset + 2]);
+        glm::vec2 uv(vertex[uvOffset], vertex[uvOffset + 1]);
+        minPosition = glm::min(minPosition, position);
+        maxPosition = glm::max(maxPosition, position);
+        minUV = glm::min(minUV, uv);
+        maxUV = glm::max(maxUV, uv);
+    }
+    for (int k = 0; k < 3; ++k) {
+        quantization.positionOffset[k] = minPosition[k];
+        quantization.positionScale[k] = maxPosition[k] - minPosition[k];
+    }
+    for (int k = 0; k < 2; ++k) {
+        quantization.uvOffset[k] = minUV[k];
+        quantization.uvScale[k] = maxUV[k] - minUV[k];
+    }
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* vertex = vertices + i * stride;
+        PackedVertex& out = packed[i];
+        for (int k = 0; k < 3; ++k)
+            out.position[k] = quantizeUnorm(vertex[positionOffset + k], quantization.positionOffset[k], quantization.positionScale[k]);
+        out.padding = 0;
+
+        glm::vec2 normal = EncodeOctahedral(glm::vec3(vertex[normalOffset], vertex[normalOffset + 1], vertex[normalOffset + 2]));
+        out.normal[0] = quantizeSnorm(normal.x);
+        out.normal[1] = quantizeSnorm(normal.y);
+
+        for (int k = 0; k < 2; ++k)
+            out.uv[k] = quantizeUnorm(vertex[uvOffset + k], quantization.uvOffset[k], quantization.uvScale[k]);
+    }
+    return quantization;
+}
+
+// the normal is projected on the octahedron |x| + |y| + |z| = 1, the lower half is folded over the upper one
+glm::vec2 VertexPacking::EncodeOctahedral(const glm::vec3& normal) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length <= 0.0f)
+        return glm::vec2(0.0f);
+
+    glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+    if (normal.z < 0.0f) {
+        glm::vec2 sign(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * sign;
+    }
+    return encoded;
+}
+
+// the same as decodeNormal in Packing.GLSL
+glm::vec3 VertexPacking::DecodeOctahedral(const glm::vec2& encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
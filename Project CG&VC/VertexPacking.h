@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// 16 bytes instead of the 32 of position, normal and uv as floats
+struct PackedVertex {
+	uint16_t position[3];	// UNORM16 inside the bounds of the mesh
+	uint16_t padding;
+	int16_t normal[2];		// octahedral, SNORM16
+	uint16_t uv[2];			// UNORM16 inside the uv bounds of the mesh
+};
+
+// Turns the normalized position and uv back into mesh space: value * scale + offset
+struct VertexQuantization {
+	float positionOffset[3] = { 0.0f, 0.0f, 0.0f };
+	float positionScale[3] = { 1.0f, 1.0f, 1.0f };
+	float uvOffset[2] = { 0.0f, 0.0f };
+	float uvScale[2] = { 1.0f, 1.0f };
+};
+
+/*
+* Packing of float vertices into the PackedVertex format, without OpenGL so the converters can bake it
+* containts:
+*		- quantization of positions and uvs relative to their bounds
+*		- the octahedral normal encoding, decoded again by decodeNormal in Packing.GLSL
+*/
+class VertexPacking {
+public:
+	// offsets are in floats inside a vertex of stride floats
+	static VertexQuantization Pack(const float* vertices, size_t vertexCount, size_t stride,
+		size_t positionOffset, size_t normalOffset, size_t uvOffset, std::vector<PackedVertex>& packed);
+
+	static glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+	static glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+};
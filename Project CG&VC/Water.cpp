@@ -1,10 +1,12 @@
 #include "Water.h"
+#include "AssetLoader.h"
 #include "Shader.h"
 
 Water::Water(float seaLevel, const std::string heightmapPath) : seaLevel(seaLevel), m_shader(".\\waterShader.vert", ".\\waterShader.frag") {
-	int width, height, nChannels;
-	unsigned char* data = stbi_load(heightmapPath.c_str(), &width, &height, &nChannels, 0);
-	if (!data) {
+	// only the size of the heightmap is needed, the decode is shared with the Heightmap
+	std::shared_ptr<const ImageData> image = AssetLoader::Get().TakeImage(heightmapPath, 0, true);
+	int width = image->width, height = image->height;
+	if (!image->pixels) {
 		std::cerr << "Failed to load heightmap: " << heightmapPath << std::endl;
 		return;
 	}
@@ -37,7 +39,12 @@ Water::Water(float seaLevel, const std::string heightmapPath) : seaLevel(seaLeve
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	waterTextureID = Utilities::loadTexture(".\\textures\\water.jpg");
+	waterTexture = Utilities::loadTexture(".\\textures\\water.jpg");
+}
+
+void Water::Prefetch(const std::string& heightmapPath) {
+	AssetLoader::Get().PrefetchImage(heightmapPath, 0, true);
+	TextureCache::Prefetch(".\\textures\\water.jpg", TextureSettings::Terrain());
 }
 
 void Water::Render(const glm::mat4& projection, const glm::mat4& view) {
@@ -56,7 +63,7 @@ void Water::Render(const glm::mat4& projection, const glm::mat4& view) {
 	m_shader.setInt("waterTexture", 0);
 
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, waterTextureID);
+	glBindTexture(GL_TEXTURE_2D, waterTexture->id);
 
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(-1.0f, -1.0f);	// Negative values push the water closer to the camera
@@ -11,6 +11,7 @@
 class Water {
 public:
 	Water(float seaLevel, const std::string heightmapPath);
+	static void Prefetch(const std::string& heightmapPath);
 	void Render(const glm::mat4& projection, const glm::mat4& view);
 
 	void SetTime(float time);
@@ -19,6 +20,6 @@ private:
 	Shader m_shader;
 
 	unsigned int VAO, VBO;
-	unsigned int waterTextureID;
+	std::shared_ptr<TextureResource> waterTexture;
 	float seaLevel;
 };
\ No newline at end of file
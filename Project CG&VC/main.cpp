@@ -6,6 +6,11 @@
 
 #include "stb_image.h"
 #include <iostream>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <cstdlib>
 #include "Camera.h"
 #include "Shader.h"
 #include "Heightmap.h"
@@ -13,6 +18,7 @@
 #include "BezierCurve.h"
 #include "Rollercoaster.h"
 #include "Cart.h"
+#include "TrainSystem.h"
 #include "BezierTrack.h"
 #include "Tree.h"
 #include "Boat.h"
@@ -25,10 +31,13 @@
 #include "ChromaKey.h"
 #include "ParticleSystem.h"
 #include "Light.h"
+#include "LightUniformBuffer.h"
 #include "Utilities.h"
 #include "SkyBox.h"
 #include "PostProcessor.h"
 #include "PostProcessKernel.h"
+#include "RideRecording.h"
+#include "AssetLoader.h"
 
 // Screen size
 const unsigned int SCR_WIDTH = 1920;
@@ -51,6 +60,25 @@ bool fireActive = false;
 ColorPicker* colorPicker = nullptr;
 Sphere* redSphere = nullptr;
 
+// track editing, [ and ] select a control point, arrow keys and page up/down move it
+RollerCoaster* editCoaster = nullptr;
+int editSegment = 0;
+int editPoint = 3;
+bool trackEdited = false;
+
+// P switches the cart between physics and the constant speed ride
+Cart* rideCart = nullptr;
+
+// stress test: + and - add or remove 100 trains, Y switches between one and all threads
+TrainSystem* stressTrains = nullptr;
+
+// benchmarks: --record <file> writes the ride to a file, --replay <file> plays it back at a fixed
+// timestep (--timestep <seconds>, default 1/60) and prints the frame time percentiles. A recording only
+// holds the camera, the toggles, the train count and the cart, so track edits, P and Y are ignored
+// while recording and a replay runs on the same track and thread count as the recorded session
+bool recordingRide = false;
+bool replaying = false;
+
 // lighting
 std::vector<glm::vec3> lightPos = {
 	{ 20.0f, 75.0f, 0.0f },
@@ -88,74 +116,86 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 GLFWwindow* InitializeGLFW();
 
 
-int main() {
+int main(int argc, char** argv) {
+	std::string recordPath;
+	std::string replayPath;
+	float replayTimestep = 1.0f / 60.0f;
+	for (int i = 1; i + 1 < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--record")
+			recordPath = argv[++i];
+		else if (argument == "--replay")
+			replayPath = argv[++i];
+		else if (argument == "--timestep")
+			replayTimestep = std::max(static_cast<float>(std::atof(argv[++i])), 0.0001f);
+	}
+
+	RideRecording recording;
+	recordingRide = !recordPath.empty();
+	if (!replayPath.empty()) {
+		try {
+			recording = RideRecording::Load(replayPath);
+		}
+		catch (const std::exception& e) {
+			std::cout << "ERROR::REPLAY::" << e.what() << std::endl;
+			return -1;
+		}
+		replaying = true;
+	}
+	size_t replayFrame = 0;
+	std::vector<float> frameTimes;
+	frameTimes.reserve(recording.frames.size());
+
 	//Initialize GLFW window
 	GLFWwindow* window = InitializeGLFW();
 	if (!window) { return -1; }
 
+	// a replay measures the render cost, vsync would hold every frame to the refresh rate
+	if (replaying)
+		glfwSwapInterval(0);
+
+	// read, decode and import the assets of the scene on the loader threads, the constructors below
+	// only upload them (and wait when a worker isn't done yet)
+	Model::Prefetch(".\\models\\cart\\coaster-train-front.fbx");
+	Model::Prefetch(".\\models\\cart\\coaster-train.fbx");
+	Heightmap::Prefetch(".\\heightmap.jpeg", ".\\textures");
+	Model::Prefetch(".\\models\\scenery\\tree.fbx");
+	Model::Prefetch(".\\models\\scenery\\boat-row-small.fbx");
+	Model::Prefetch(".\\models\\scenery\\ship-medium.fbx");
+	Model::Prefetch(".\\models\\scenery\\ship-wreck.fbx");
+	Model::Prefetch(".\\models\\scenery\\tower-complete-large.fbx");
+	Model::Prefetch(".\\models\\scenery\\cannon-mobile.fbx");
+	ParticleSystem::Prefetch(".\\fire.png");
+	Water::Prefetch(".\\heightmap.jpeg");
+	Model::Prefetch(".\\models\\lamp\\JapaneseLamp.obj");
+	SkyBox::Prefetch();
+
 	colorPicker = new ColorPicker(SCR_WIDTH, SCR_HEIGHT);
 
 	PostProcessor postProcessor(SCR_WIDTH, SCR_HEIGHT, ".\\PostProcessShader.vert", ".\\PostProcessShader.frag");
 
-	std::vector<std::vector<glm::vec3>> bezierSegments = {
-		// Segment 1: Start met steile klim
-		{
-			{-120.0f, 30.0f, -120.0f},                // Beginpunt
-			{-90.0f, 35.0f, -90.0f},                  // Langzame start
-			{-60.0f, 50.0f, -60.0f},                  // Steile klim
-			{0.0f, 80.0f, 0.0f}                       // Hoge top (verhoogd)
-		},
-		// Segment 2: Steile afdaling
-		{
-			{0.0f, 80.0f, 0.0f},                      // Hoge top
-			{20.0f, 60.0f, 20.0f},                    // Begin steile afdaling
-			{40.0f, 35.0f, 40.0f},                    // Voortzetting afdaling
-			{60.0f, 25.0f, 60.0f}                     // Lager eindpunt voor meer versnelling
-		},
-		// Segment 3: Looping omhoog
-		{
-			{60.0f, 25.0f, 60.0f},                    // Beginpunt laag
-			{80.0f, 15.0f, 90.0f},                    // Controle voor bocht en daling
-			{100.0f, 10.0f, 110.0f},                  // Laagste punt
-			{120.0f, 40.0f, 120.0f}                   // Omhoog na dip
-		},
-		// Segment 4: Snelle bocht met banking naar rechts
-		{
-			{120.0f, 40.0f, 120.0f},                  // Start hoog
-			{130.0f, 45.0f, 60.0f},                   // Banking naar rechts (hoger)
-			{130.0f, 40.0f, 0.0f},                    // Banking houden
-			{120.0f, 35.0f, -60.0f}                   // Uitkomen van bocht
-		},
-		// Segment 5: Kurketrekker (eerste deel)
-		{
-			{120.0f, 35.0f, -60.0f},                  // Start kurketrekker
-			{100.0f, 50.0f, -90.0f},                  // Omhoog en draai
-			{60.0f, 55.0f, -100.0f},                  // Hoogste punt kurketrekker
-			{20.0f, 45.0f, -80.0f}                    // Begin afdaling
-		},
-		// Segment 6: Kurketrekker (tweede deel)
-		{
-			{20.0f, 45.0f, -80.0f},                   // Vervolg kurketrekker
-			{0.0f, 35.0f, -70.0f},                    // Naar beneden draaien
-			{-30.0f, 25.0f, -90.0f},                  // Laagste punt
-			{-60.0f, 20.0f, -120.0f}                  // Eindpunt kurketrekker
-		},
-		// Segment 7: Laatste heuvels en naar start
-		{
-			{-60.0f, 20.0f, -120.0f},                 // Beginpunt laatste segment
-			{-75.0f, 35.0f, -110.0f},                 // Kleine heuvel omhoog
-			{-90.0f, 25.0f, -130.0f},                 // Kleine dip
-			{-120.0f, 30.0f, -120.0f}                 // Terug bij start
-		}
-	};
-
-	BezierTrack track(bezierSegments);
+	// the track is authored in tracks/default.track (a binary .trackb loads the same way)
+	std::unique_ptr<BezierTrack> track;
+	try {
+		track = std::make_unique<BezierTrack>(".\\tracks\\default.track");
+	}
+	catch (const std::exception& e) {
+		std::cout << "ERROR::TRACK::" << e.what() << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
-	// Create the rollercoaster
-	RollerCoaster rollerCoaster(track.GetSegments(), 32);
+	// Create the rollercoaster, the baked mesh next to the track is used when it still matches
+	RollerCoaster rollerCoaster(track->GetSegments(), 32, ".\\tracks\\default.trackmesh");
 
 	// Create a cart
-	Cart cart(&rollerCoaster, 40.0f); 
+	int trainCars = 6;
+	Cart cart(&rollerCoaster, 40.0f, trainCars); 
+	editCoaster = &rollerCoaster;
+	rideCart = &cart;
+
+	TrainSystem trainSystem(&rollerCoaster, trainCars);
+	stressTrains = &trainSystem;
 
 
 	// Create Heightmap
@@ -268,37 +308,37 @@ int main() {
 	float fireSpacing = 8.0f; 
 	float halfWidth = 2.5f * 0.5f; 
 
-	for (const auto& segment : track.GetSegments()) {
-		BezierCurve curve(segment);
-		std::vector<glm::vec3> points = curve.GeneratePoints(100);
-
-		float accumulated = 0.0f;
-		for (size_t i = 1; i < points.size(); ++i) {
-			glm::vec3 prev = points[i - 1];
-			glm::vec3 curr = points[i];
-			float dist = glm::length(curr - prev);
-			accumulated += dist;
-			if (accumulated >= fireSpacing) {
-				glm::vec3 direction = glm::normalize(curr - prev);
-				glm::vec3 up(0, 1, 0);
-				if (glm::length(glm::cross(direction, up)) < 0.01f)
-					up = glm::vec3(1, 0, 0);
-				glm::vec3 right = glm::normalize(glm::cross(up, direction));
-				up = glm::normalize(glm::cross(direction, right));
-
-				firePositionsLeft.push_back(curr - right * halfWidth);
-				firePositionsRight.push_back(curr + right * halfWidth);
-
-				accumulated = 0.0f;
+	// ParticleSystem owns GL objects and can't be copied, a deque never moves the emitters it already has.
+	// Every side keeps its own pool that only grows, so an emitter stays on its side after an edit.
+	std::deque<ParticleSystem> fireEmittersLeft;
+	std::deque<ParticleSystem> fireEmittersRight;
+
+	// place the emitters along the baked track samples, again after every track edit
+	auto placeFires = [&]() {
+		firePositionsLeft.clear();
+		firePositionsRight.clear();
+		const TrackSampler& trackSampler = rollerCoaster.getSampler();
+		for (int curve = 0; curve < trackSampler.GetCurveCount(); ++curve) {
+			float accumulated = 0.0f;
+			for (int i = 1; i <= trackSampler.GetSamplesPerCurve(); ++i) {
+				const TrackSample& prev = trackSampler.GetSample(curve, i - 1);
+				const TrackSample& curr = trackSampler.GetSample(curve, i);
+				accumulated += curr.distance - prev.distance;
+				if (accumulated >= fireSpacing) {
+					firePositionsLeft.push_back(curr.position - curr.right * halfWidth);
+					firePositionsRight.push_back(curr.position + curr.right * halfWidth);
+
+					accumulated = 0.0f;
+				}
 			}
 		}
-	}
 
-	std::vector<ParticleSystem> fireEmitters;
-	for (const auto& pos : firePositionsLeft)
-		fireEmitters.emplace_back(50, ".\\fire.png");
-	for (const auto& pos : firePositionsRight)
-		fireEmitters.emplace_back(50, ".\\fire.png");
+		while (fireEmittersLeft.size() < firePositionsLeft.size())
+			fireEmittersLeft.emplace_back(50, ".\\fire.png");
+		while (fireEmittersRight.size() < firePositionsRight.size())
+			fireEmittersRight.emplace_back(50, ".\\fire.png");
+	};
+	placeFires();
 
 
 	// Create water plane
@@ -311,14 +351,28 @@ int main() {
 		pointLights.push_back({ lightPos[i], lightColor[i], constant, linear, quadratic});
 		lights.emplace_back(lightPos[i], ".\\models\\lamp\\JapaneseLamp.obj", lightColor[i]);
 	}
-
+	LightUniformBuffer lightBuffer;
 
 	SkyBox skybox(".\\SkyBoxShader.vert", ".\\SkyBoxShader.frag");
+	ChromaKey chromaKey(SCR_WIDTH, SCR_HEIGHT, ".\\models\\ChromaKeying\\dog.jpeg");
+
+	// every model file is imported once, however many objects use it; printed after the last model and texture owner exists
+	ModelCacheStats modelStats = ModelCache::GetStats();
+	std::cout << "Models: " << modelStats.uniqueModels << " files for " << modelStats.references << " objects, "
+		<< modelStats.hits << " imports saved, " << modelStats.gpuBytes / (1024 * 1024) << " MB on the GPU" << std::endl;
+	TextureCacheStats textureStats = TextureCache::GetStats();
+	std::cout << "Textures: " << textureStats.textures << " resident for " << textureStats.references << " users, "
+		<< textureStats.hits << " uploads saved, " << textureStats.residentBytes / (1024 * 1024) << " MB resident" << std::endl;
+
+
+	// per asset timings of the startup
+	AssetLoader::Get().Finish();
 
 	while (!glfwWindowShouldClose(window)) {
 		// Time 
 		// -------------------------
-		float currentFrame = static_cast<float>(glfwGetTime());
+		double frameStart = glfwGetTime();
+		float currentFrame = static_cast<float>(frameStart);
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
@@ -326,6 +380,26 @@ int main() {
 		// -------------------------
 		processInput(window);
 
+		// a replay overrides the clock, the camera and the toggles with the recorded frame
+		const RecordedFrame* replayed = nullptr;
+		if (replaying) {
+			if (replayFrame >= recording.frames.size()) {
+				glfwSetWindowShouldClose(window, true);
+				break;
+			}
+			replayed = &recording.frames[replayFrame];
+			deltaTime = replayTimestep;
+			currentFrame = replayFrame * replayTimestep;
+			++replayFrame;
+
+			camera.cameraOption = replayed->cameraOption;
+			camera.SetPose(glm::vec3(replayed->position[0], replayed->position[1], replayed->position[2]), replayed->yaw, replayed->pitch, replayed->zoom);
+			fireActive = replayed->fireActive != 0;
+			currentKernelType = static_cast<PostProcessKernel::Type>(replayed->kernel);
+			if (trainSystem.GetTrainCount() != static_cast<int>(replayed->trainCount))
+				trainSystem.SetTrainCount(replayed->trainCount);
+		}
+
 		// Render
 		// --------------------------
 		postProcessor.StartRender();
@@ -347,16 +421,40 @@ int main() {
 			pointLights[i].color = lights[i].color;
 			lights[i].Render(projection, view);
 		}
+		lightBuffer.Update(pointLights);
 
 		// Render the rollercoaster
 		rollerCoaster.Render(projection, view);
 
 		// Render the cart
-		cart.Update(deltaTime);
-		cart.Render(projection, view, pointLights, camera.Position);
+		if (replayed)
+			cart.ApplySnapshot(replayed->cart);
+		else
+			cart.Update(deltaTime);
+
+		if (!recordPath.empty()) {
+			RecordedFrame frame = {};
+			frame.position[0] = camera.Position.x;
+			frame.position[1] = camera.Position.y;
+			frame.position[2] = camera.Position.z;
+			frame.yaw = camera.Yaw;
+			frame.pitch = camera.Pitch;
+			frame.zoom = camera.Zoom;
+			frame.cameraOption = static_cast<uint8_t>(camera.cameraOption);
+			frame.fireActive = fireActive ? 1 : 0;
+			frame.kernel = static_cast<uint8_t>(currentKernelType);
+			frame.trainCount = static_cast<uint32_t>(trainSystem.GetTrainCount());
+			frame.cart = cart.GetSnapshot();
+			recording.frames.push_back(frame);
+		}
+		cart.Render(projection, view, camera.Position);
+
+		trainSystem.Update(deltaTime);
+		trainSystem.Render(projection, view, camera.Position);
 
 
 		//Render Trees
+		Scenery::ResetRenderStats();
 		for (auto& tree : trees) {
 			tree.Render(projection, view);
 		}
@@ -390,19 +488,26 @@ int main() {
 		redSphere->Render(projection, view);
 
 		//render vuur 
+		if (trackEdited) {
+			placeFires();
+			cart.OnTrackEdited();
+			trainSystem.RebuildSlopeTable();
+			trackEdited = false;
+		}
+		// an edited track can have fewer fires than there are emitters, the spare ones are skipped
 		for (size_t i = 0; i < firePositionsLeft.size(); ++i) {
-			fireEmitters[i].SetActive(fireActive);
-			fireEmitters[i].Update(deltaTime, firePositionsLeft[i]);
-			fireEmitters[i].Render(projection, view);
+			fireEmittersLeft[i].SetActive(fireActive);
+			fireEmittersLeft[i].Update(deltaTime, firePositionsLeft[i]);
+			fireEmittersLeft[i].Render(projection, view);
 		}
 		for (size_t i = 0; i < firePositionsRight.size(); ++i) {
-			fireEmitters[i + firePositionsLeft.size()].SetActive(fireActive);
-			fireEmitters[i + firePositionsLeft.size()].Update(deltaTime, firePositionsRight[i]);
-			fireEmitters[i + firePositionsLeft.size()].Render(projection, view);
+			fireEmittersRight[i].SetActive(fireActive);
+			fireEmittersRight[i].Update(deltaTime, firePositionsRight[i]);
+			fireEmittersRight[i].Render(projection, view);
 		}
 
 		if (camera.cameraOption == 1)
-			camera.UpdateCartCamera(cart.GetPosition(), cart.GetDirection());
+			camera.UpdateCartCamera(cart.GetPosition(), cart.GetDirection(), cart.GetUp());
 
 
 		// Render the heightmap
@@ -423,9 +528,6 @@ int main() {
 		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
 
 		//chroma keying
-		static ChromaKey chromaKey(SCR_WIDTH, SCR_HEIGHT,
-			".\\models\\ChromaKeying\\dog.jpeg"
-		);
 		chromaKey.Render();
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -433,6 +535,26 @@ int main() {
 		//Poll for events
 		glfwPollEvents();
 		glfwSwapBuffers(window);
+
+		if (replaying)
+			frameTimes.push_back(static_cast<float>((glfwGetTime() - frameStart) * 1000.0));
+	}
+
+	if (!recordPath.empty()) {
+		try {
+			recording.Save(recordPath);
+			std::cout << "Recorded " << recording.frames.size() << " frames to " << recordPath << std::endl;
+		}
+		catch (const std::exception& e) {
+			std::cout << "ERROR::RECORD::" << e.what() << std::endl;
+		}
+	}
+
+	if (replaying) {
+		FrameTimePercentiles percentiles = RideRecording::ComputePercentiles(frameTimes);
+		std::cout << "Replay: " << percentiles.frames << " frames at a timestep of " << replayTimestep * 1000.0f << " ms" << std::endl;
+		std::cout << "Frame time: p50 " << percentiles.p50 << " ms, p95 " << percentiles.p95 << " ms, p99 "
+			<< percentiles.p99 << " ms, max " << percentiles.max << " ms" << std::endl;
 	}
 
 	glfwTerminate();
@@ -493,8 +615,8 @@ void processInput(GLFWwindow* window) {
 		glfwSetWindowShouldClose(window, true);
 
 
-	// camera controls
-	if (camera.cameraOption == 0) {
+	// camera controls, a replay moves the camera itself
+	if (camera.cameraOption == 0 && !replaying) {
 		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 			camera.ProcessKeyboard(FORWARD, deltaTime);
 		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -508,6 +630,9 @@ void processInput(GLFWwindow* window) {
 
 // glfw: whenever the mouse moves, this callback is called
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
+	if (replaying)
+		return;
+
 	float xpos = static_cast<float>(xposIn);
 	float ypos = static_cast<float>(yposIn);
 
@@ -558,6 +683,10 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
 	std::cout << key << "pressed" << std::endl;
+	// the recording decides everything during a replay, only escape (processInput) still works
+	if (replaying)
+		return;
+
 	if (key == GLFW_KEY_Q && action == GLFW_PRESS)
 		camera.ChangeOption();
 
@@ -576,6 +705,87 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 		std::cout << "Kernel changed to: " << PostProcessKernel(currentKernelType).Name() << std::endl;
 	}
+
+	// the recording doesn't hold the physics switch, the thread count or track edits
+	if (recordingRide && (key == GLFW_KEY_P || key == GLFW_KEY_Y || key == GLFW_KEY_LEFT || key == GLFW_KEY_RIGHT || key == GLFW_KEY_UP
+		|| key == GLFW_KEY_DOWN || key == GLFW_KEY_PAGE_UP || key == GLFW_KEY_PAGE_DOWN)) {
+		if (action == GLFW_PRESS)
+			std::cout << "Ignored while recording: track edits, cart physics (P) and threads (Y)" << std::endl;
+		return;
+	}
+
+	if (rideCart && key == GLFW_KEY_P && action == GLFW_PRESS) {
+		rideCart->SetPhysicsEnabled(!rideCart->IsPhysicsEnabled());
+		std::cout << "Cart physics " << (rideCart->IsPhysicsEnabled() ? "on" : "off") << std::endl;
+	}
+
+	if (stressTrains && (key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD || key == GLFW_KEY_MINUS || key == GLFW_KEY_KP_SUBTRACT)
+		&& (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		int change = (key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD) ? 100 : -100;
+		stressTrains->SetTrainCount(stressTrains->GetTrainCount() + change);
+		std::cout << "Stress test: " << stressTrains->GetTrainCount() << " trains" << std::endl;
+	}
+
+	if (stressTrains && key == GLFW_KEY_Y && action == GLFW_PRESS) {
+		stressTrains->SetThreadCount(stressTrains->GetThreadCount() == 1 ? 0 : 1);
+		std::cout << "Stress test: " << stressTrains->GetThreadCount() << " thread(s)" << std::endl;
+	}
+
+	// track statistics, and the closest point of the track to the camera
+	if (editCoaster && key == GLFW_KEY_T && action == GLFW_PRESS) {
+		const TrackRenderStats& stats = editCoaster->getRenderStats();
+		std::cout << "Track: " << stats.chunks - stats.culledChunks << "/" << stats.chunks << " chunks drawn, "
+			<< stats.culledChunks << " culled, " << stats.triangles << " triangles" << std::endl;
+
+		const TrackEditStats& editStats = editCoaster->getEditStats();
+		if (editStats.segments > 0)
+			std::cout << "Last track edit: " << editStats.segments << " segment(s) rebuilt" << (editStats.fullUpload ? " (full upload)" : "")
+				<< " in " << editStats.milliseconds << " ms" << std::endl;
+
+		TrackPoint nearest = editCoaster->FindNearestPoint(camera.Position);
+		std::cout << "Nearest track point: segment " << nearest.curve << " t " << nearest.t << " at " << nearest.distance << " units" << std::endl;
+
+		if (stressTrains) {
+			const TrainSystemStats& trainStats = stressTrains->GetStats();
+			std::cout << "Trains: " << trainStats.trains << " on " << stressTrains->GetThreadCount() << " thread(s), "
+				<< trainStats.steps << " steps in " << trainStats.simulateMs << " ms, matrices in " << trainStats.prepareMs << " ms" << std::endl;
+		}
+	}
+
+	// scenery statistics of the last frame, per level of detail
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		const SceneryRenderStats& stats = Scenery::GetRenderStats();
+		std::cout << "Scenery:";
+		for (int lod = 0; lod < Model::MAX_LODS; ++lod)
+			std::cout << " LOD " << lod << " " << stats.instances[lod] << " objects " << stats.triangles[lod] << " triangles" << (lod + 1 < Model::MAX_LODS ? "," : "");
+		std::cout << std::endl;
+	}
+
+	// track editing: the start point of a segment is the end point of the previous one, so only 1..3 are selectable
+	if (editCoaster && (key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET) && action == GLFW_PRESS) {
+		int segmentCount = static_cast<int>(editCoaster->getTrack().GetSegments().size());
+		int selection = editSegment * 3 + (editPoint - 1) + (key == GLFW_KEY_RIGHT_BRACKET ? 1 : -1);
+		selection = (selection + segmentCount * 3) % (segmentCount * 3);
+		editSegment = selection / 3;
+		editPoint = selection % 3 + 1;
+		std::cout << "Selected control point " << editPoint << " of segment " << editSegment << std::endl;
+	}
+
+	if (editCoaster && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		glm::vec3 move(0.0f);
+		if (key == GLFW_KEY_LEFT) move.x = -1.0f;
+		if (key == GLFW_KEY_RIGHT) move.x = 1.0f;
+		if (key == GLFW_KEY_UP) move.z = -1.0f;
+		if (key == GLFW_KEY_DOWN) move.z = 1.0f;
+		if (key == GLFW_KEY_PAGE_UP) move.y = 1.0f;
+		if (key == GLFW_KEY_PAGE_DOWN) move.y = -1.0f;
+
+		if (move != glm::vec3(0.0f)) {
+			glm::vec3 point = editCoaster->getTrack().GetSegments()[editSegment][editPoint];
+			editCoaster->MoveControlPoint(editSegment, editPoint, point + move);
+			trackEdited = true;
+		}
+	}
 }
 
 // glfw: whenever the window size changed, this callback function executes